@@ -0,0 +1,70 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <string>
+
+#include "symbol.hh"
+#include "bitreedict.hh"
+#include "profile.hh"
+
+//////////////////////////////////////////////////////////////////////
+// bitree_dict
+
+bitree_dict::bitree_dict() : reversed() {
+}
+
+void bitree_dict::addword(symbol *str, int n) {
+  btree_dict::addword(str, n);
+  symbol rev[n];
+  for (int i = 0; i < n; i++)
+    rev[i] = str[n-1-i];
+  reversed[n].addword(rev, n);
+}
+
+void bitree_dict::finishwords() {
+  btree_dict::finishwords();
+  forlengths(reachlength, reversed, reachweight());
+}
+
+symbolset bitree_dict::findpossible(symbol *s, int len, int pos) {
+  int prefix = 0, suffix = 0;
+  while ((prefix < len) && (s[prefix] != symbol::empty)) prefix++;
+  while ((suffix < len) && (s[len-1-suffix] != symbol::empty)) suffix++;
+  if (suffix <= prefix)
+    return btree_dict::findpossible(s, len, pos);
+
+  symbol rev[MAXWORDLEN + 1];
+  for (int i = 0; i < len; i++)
+    rev[i] = s[len-1-i];
+  rev[len] = symbol::outside;
+  return findtrie(reversed[len], rev, len, len-1-pos);
+}
+
+long bitree_dict::memusage() {
+  long n = 0;
+  for (int i = 0; i < MAXWORDLEN; i++)
+    n += reversed[i].countnodes() * sizeof(symbollink)
+      + reversed[i].reachbytes(i);
+  return btree_dict::memusage() + n;
+}
+
+void bitree_dict::profilemem() {
+  btree_dict::profilemem();
+  profiler.addmem("reverse trie", memusage() - btree_dict::memusage());
+}
@@ -0,0 +1,44 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef BITREEDICT_HH
+#define BITREEDICT_HH
+
+#include "symbol.hh"
+#include "dict.hh"
+
+/**
+ * The bidirectional tree index keeps a trie of the reversed words
+ * next to the forward trie of btree_dict. A query walks from the end
+ * of the pattern with the longer run of known letters, so slots whose
+ * known letters sit at the end do not fan out over every prefix.
+ */
+
+class bitree_dict : public btree_dict {
+  symbollink reversed[MAXWORDLEN];
+public:
+  bitree_dict();
+  void addword(symbol *, int);
+  void finishwords();
+  symbolset findpossible(symbol *s, int len, int pos);
+  long memusage();
+  void profilemem();
+};
+
+#endif
@@ -0,0 +1,238 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <pthread.h>
+#include <math.h>
+#include <iostream.h>
+#include <algo.h>
+
+#include "symbol.hh"
+#include "cwc.hh"
+#include "components.hh"
+
+//////////////////////////////////////////////////////////////////////
+// deep searches
+
+#define STACKPERCELL 2048
+
+size_t searchstack(int ncells) {
+  return (8 << 20) + size_t(ncells) * STACKPERCELL;
+}
+
+struct stackjob {
+  solvetask *task;
+  string err;
+};
+
+static void *runjob(void *arg) {
+  stackjob *job = (stackjob*)arg;
+  try {
+    job->task->run();
+  } catch (error e) {
+    job->err = e.what();
+  }
+  return 0;
+}
+
+void runwithstack(solvetask &task, int ncells) {
+  stackjob job;
+  job.task = &task;
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, searchstack(ncells));
+  pthread_t tid;
+  int failed = pthread_create(&tid, &attr, runjob, &job);
+  pthread_attr_destroy(&attr);
+  if (failed)
+    throw error("Failed to start solver thread");
+  pthread_join(tid, 0);
+  if (!job.err.empty())
+    throw error(job.err);
+}
+
+// larger parts first, so parallel threads finish together
+struct partorder {
+  bool operator()(const vector<int> &a, const vector<int> &b) const {
+    if (a.size() != b.size()) return a.size() > b.size();
+    return a[0] < b[0];
+  }
+};
+
+//////////////////////////////////////////////////////////////////////
+// class componentsolver
+
+componentsolver::componentsolver(grid &thegrid, dict &thedict)
+  : g(thegrid), d(thedict), nextpart(0), failed(false),
+    verbose(false), showsteps(false), progressinterval(500), engine(""), seed(0),
+    aborted(false) {
+  pthread_mutex_init(&lock, 0);
+}
+
+componentsolver::~componentsolver() {
+  pthread_mutex_destroy(&lock);
+}
+
+/**
+ * finds the parts by a breadth first search over the empty cells,
+ * following the slots through each cell.
+ */
+
+void componentsolver::analyze() {
+  int ncells = g.numcells();
+  vector<int> part(ncells, -1);
+  parts.clear();
+  for (int start = 0; start < ncells; start++) {
+    if (!g.cellno(start).isempty() || part[start] >= 0)
+      continue;
+    int p = parts.size();
+    parts.push_back(vector<int>());
+    vector<int> &cells = parts.back();
+    part[start] = p;
+    cells.push_back(start);
+    for (unsigned next = 0; next < cells.size(); next++) {
+      cell &c = g.cellno(cells[next]);
+      for (int w = 0; w < c.numwords(); w++) {
+	wordblock &wb = c.getwordblock(w);
+	for (int i = 0; i < wb.length(); i++) {
+	  int n = wb.getcellno(i);
+	  if (g.cellno(n).isempty() && part[n] < 0) {
+	    part[n] = p;
+	    cells.push_back(n);
+	  }
+	}
+      }
+    }
+    sort(cells.begin(), cells.end());
+  }
+  sort(parts.begin(), parts.end(), partorder());
+}
+
+/**
+ * log10 of the search space: the parts are searched one by one, so
+ * their fillings add.
+ */
+
+double componentsolver::logspace() {
+  double logalpha = log10(double(symbol::numalpha())), top = 0;
+  for (int p = 0; p < numparts(); p++)
+    if (parts[p].size() * logalpha > top)
+      top = parts[p].size() * logalpha;
+  double sum = 0;
+  for (int p = 0; p < numparts(); p++)
+    sum += pow(10, parts[p].size() * logalpha - top);
+  return top + log10(sum);
+}
+
+bool componentsolver::solvepart(int p, walker &w, bool progress) {
+  w.setregion(parts[p]);
+  smart_backtracker bt(g);
+  compiler c(g, w, bt, d);
+  c.stats.engine = engine;
+  c.verbose = verbose;
+  c.showsteps = showsteps && progress;
+  c.progressinterval = progressinterval;
+  // the part's choices depend on the run seed and the part only
+  unsigned state = seed + 7919*(p+1);
+  pickseed(&state);
+  bool ok = c.compile();
+  pickseed(0);
+
+  pthread_mutex_lock(&lock);
+  stats.merge(c.stats);
+  // counted within the part's own space, which logspace() adds up
+  rejected.add(c.getrejected());
+  if (c.wasaborted())
+    aborted = true;
+  if (!ok)
+    failed = true;
+  pthread_mutex_unlock(&lock);
+  return ok;
+}
+
+void *componentsolver::worker(void *arg) {
+  componentsolver *cs = (componentsolver*)arg;
+  walker *w = newwalker(cs->walkertype, cs->g);
+  while (1) {
+    pthread_mutex_lock(&cs->lock);
+    int p = cs->failed ? cs->numparts() : cs->nextpart++;
+    pthread_mutex_unlock(&cs->lock);
+    if (p >= cs->numparts())
+      break;
+    try {
+      cs->solvepart(p, *w, false);
+    } catch (error e) {
+      pthread_mutex_lock(&cs->lock);
+      if (cs->threaderror.empty())
+	cs->threaderror = e.what();
+      cs->failed = true;
+      pthread_mutex_unlock(&cs->lock);
+    }
+  }
+  delete w;
+  return 0;
+}
+
+/**
+ * solves every part, with up to the given number of threads. Stops
+ * handing out parts when one has no solution.
+ */
+
+bool componentsolver::solve(setup_s::walker_t type, int threads) {
+  walkertype = type;
+  stats.reset();
+  stats.engine = engine;
+  rejected = spacecount();
+  failed = aborted = false;
+  nextpart = 0;
+  spacecount::setbase(symbol::numalpha(), g.numopen());
+
+  if (threads > numparts())
+    threads = numparts();
+  if (threads <= 1) {
+    walker *w = newwalker(type, g);
+    for (int p = 0; p < numparts() && !failed; p++)
+      solvepart(p, *w, true);
+    delete w;
+    return !failed;
+  }
+
+  vector<pthread_t> tids(threads);
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, searchstack(partsize(0)));
+  int started = 0;
+  while (started < threads &&
+	 pthread_create(&tids[started], &attr, worker, this) == 0)
+    started++;
+  pthread_attr_destroy(&attr);
+  if (started < threads) {
+    // stop the running workers before the solver can go away
+    pthread_mutex_lock(&lock);
+    failed = true;
+    pthread_mutex_unlock(&lock);
+    for (int t = 0; t < started; t++)
+      pthread_join(tids[t], 0);
+    throw error("Failed to start solver thread");
+  }
+  for (int t = 0; t < threads; t++)
+    pthread_join(tids[t], 0);
+  if (!threaderror.empty())
+    throw error(threaderror);
+  return !failed;
+}
@@ -0,0 +1,95 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef COMPONENTS_HH
+#define COMPONENTS_HH
+
+#include <pthread.h>
+#include <vector>
+#include "main.hh"
+#include "grid.hh"
+#include "dict.hh"
+#include "stats.hh"
+#include "estimate.hh"
+
+class walker;
+
+/**
+ * Independent parts of a grid. Two empty cells depend on each other
+ * when they share a slot; filled cells carry no choice, so a slot
+ * only links its empty cells. Each connected part is then solved by
+ * its own compiler, and the search spaces of the parts add instead of
+ * multiply. A part shares no slot that has an empty cell with another
+ * part, so with -j the parts are solved by parallel threads filling
+ * the one grid; their cells never overlap, and the grid's empty cell
+ * map and the pair filter counters, which they share, are updated
+ * atomically.
+ */
+
+/**
+ * The searches recurse once per cell they fill, so solving a large
+ * grid needs a deeper stack than the main thread has. A solvetask is
+ * run on a thread with a stack sized for the given number of cells;
+ * errors thrown by the task are passed on to the caller.
+ */
+
+class solvetask {
+public:
+  virtual ~solvetask() {}
+  virtual void run() = 0;
+};
+
+size_t searchstack(int ncells);
+void runwithstack(solvetask &task, int ncells);
+
+class componentsolver {
+  grid &g;
+  dict &d;
+  vector<vector<int> > parts;   // empty cells of each part, largest first
+
+  // shared by the solving threads
+  pthread_mutex_t lock;
+  int nextpart;
+  bool failed;
+  string threaderror;           // first error thrown in a thread
+  setup_s::walker_t walkertype;
+  static void *worker(void *arg);
+  bool solvepart(int p, walker &w, bool progress);
+public:
+  componentsolver(grid &thegrid, dict &thedict);
+  ~componentsolver();
+  void analyze();
+  int numparts() { return parts.size(); }
+  int partsize(int p) { return parts[p].size(); }
+  double logspace();
+  bool solve(setup_s::walker_t type, int threads);
+
+  // passed on to the compilers
+  bool verbose, showsteps;
+  int progressinterval;
+  const char *engine;
+  unsigned seed;
+
+  // merged over the parts
+  searchstats stats;
+  spacecount rejected;
+  bool aborted;
+};
+
+#endif
@@ -25,6 +25,7 @@
 #include <sys/time.h>
 
 #include <fstream.h>
+#include <algo.h>
 #include <string>
 #include <strstream>
 #include <math.h>
@@ -37,14 +38,27 @@
 #include "symbol.hh"
 #include "dict.hh"
 #include "letterdict.hh"
+#include "layerdict.hh"
+#include "livedict.hh"
+#include "engines.hh"
+#include "dictbench.hh"
+#include "solvebench.hh"
+#include "profile.hh"
+#include "progress.hh"
+#include "pairfilter.hh"
+#include "gridscope.hh"
 #include "grid.hh"
+#include "components.hh"
+#include "treesolver.hh"
+#include "startup.hh"
 
 #include "cwc.hh"
 
 //////////////////////////////////////////////////////////////////////
 // class walker
 
-walker::walker(grid &thegrid) : current(0), g(thegrid) {
+walker::walker(grid &thegrid)
+  : stepof(thegrid.numcells(), -1), current(0), g(thegrid) {
   limit = thegrid.getempty();
   inited = false;
 }
@@ -80,8 +94,10 @@ void walker::backto_oneof(backtracker &bt) {
 
 void walker::forward() {
   if (inited) {
+    stepof[current] = cellno.size();
     cellno.push_back(current);
-    do step_forward(); while (!g.cellno(current).isempty());
+    do step_forward();
+    while (!g.cellno(current).isempty() || !inregion(current));
   } else {
     init();
     inited = true;
@@ -89,10 +105,13 @@ void walker::forward() {
 }
 
 void walker::backward(bool savepreferred) {
+  int c = current;
   if (!g.cellno(current).isoutside())
     g.cellno(current).clear(savepreferred);
   current = cellno.back();
   cellno.pop_back();
+  stepof[current] = -1;
+  cleared(c);
 }
 
 bool walker::moresteps() {
@@ -100,12 +119,19 @@ bool walker::moresteps() {
 }
 
 void walker::findnext() {
-  int ncells = g.numcells();
-  for (int i = 0; i < ncells; i++)
-    if (g.cellno(i).isempty()) {
+  if (hasregion()) {
+    for (unsigned i = 0; i < regioncells.size(); i++)
+      if (g.cellno(regioncells[i]).isempty()) {
+	current = regioncells[i];
+	return;
+      }
+  } else {
+    int i = g.nextempty(0);
+    if (i >= 0) {
       current = i;
       return;
     }
+  }
   throw error("No empty cells");
 }
 
@@ -113,23 +139,65 @@ void walker::init() {
   findnext();
 }
 
+/**
+ * restarts the walk on the given cells. Only the previous walk and
+ * region are undone, so solving many small parts in turn does not
+ * cost a pass over the grid each.
+ */
+
+void walker::setregion(const vector<int> &cells) {
+  for (unsigned i = 0; i < cellno.size(); i++)
+    stepof[cellno[i]] = -1;
+  cellno.clear();
+  inited = false;
+  restart();
+  if (region.empty())
+    region.assign(g.numcells(), false);
+  for (unsigned i = 0; i < regioncells.size(); i++)
+    region[regioncells[i]] = false;
+  regioncells = cells;
+  for (unsigned i = 0; i < cells.size(); i++)
+    region[cells[i]] = true;
+  limit = cells.size();
+}
+
+/**
+ * the cell after c in grid order: the next one of the region if
+ * there is one.
+ */
+
+int walker::after(int c) {
+  if (!hasregion())
+    return c + 1;
+  vector<int>::iterator i =
+    upper_bound(regioncells.begin(), regioncells.end(), c);
+  return i == regioncells.end() ? c + 1 : *i;
+}
+
 //////////////////////////////////////////////////////////////////////
 // class prefix_walker
 
 void prefix_walker::step_forward() {
-  current++; // not correct now
+  current = after(current); // not correct now
 }
 
 //////////////////////////////////////////////////////////////////////
 // class flood_walker
 
-flood_walker::flood_walker(grid &g) : walker(g) {
+flood_walker::flood_walker(grid &g) : walker(g), first(0) {
 }
 
+/**
+ * steps to an empty neighbour in a slot of the earliest filled cell
+ * that has one. Cells found without one are skipped next time, until
+ * a neighbour is emptied again, so a walk is linear in the grid.
+ */
+
 void flood_walker::step_forward() {
-  vector<int>::iterator i;
-  for (i = cellno.begin(); i != cellno.end(); i++) {
-    int cno = *i;
+  if (first > cellno.size())
+    first = cellno.size();
+  for (; first < cellno.size(); first++) {
+    int cno = cellno[first];
 
     int nwords = g.cellno(cno).numwords();
     for (int w = 0; w < nwords; w++) {
@@ -158,6 +226,37 @@ void flood_walker::step_forward() {
   findnext();
 }
 
+void flood_walker::cleared(int c) {
+  cell &thecell = g.cellno(c);
+  int nwords = thecell.numwords();
+  for (int w = 0; w < nwords; w++) {
+    wordblock &wb = thecell.getwordblock(w);
+    int pos = thecell.getpos(w);
+    for (int p = pos-1; p <= pos+1; p += 2) {
+      if (p < 0 || p >= wb.length()) continue;
+      int s = stepof[wb.getcellno(p)];
+      if (s >= 0 && unsigned(s) < first)
+	first = s;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+// walker construction
+
+// indexed by setup_s::walker_t
+const char *walkernames[] = { "prefix", "flood", 0 };
+
+walker *newwalker(setup_s::walker_t type, grid &g) {
+  switch (type) {
+  case setup_s::prefixwalker:
+    return new prefix_walker(g);
+  case setup_s::floodwalker:
+    return new flood_walker(g);
+  }
+  throw error("Internal error");
+}
+
 //////////////////////////////////////////////////////////////////////
 // class backtracker
 
@@ -243,8 +342,12 @@ bool smart_backtracker::stophere(int p) {
 compiler::compiler(grid &thegrid, walker &thewalker,
 		   backtracker &thebacktracker, dict &thedict)
   : g(thegrid), w(thewalker), bt(thebacktracker), d(thedict) {
-  g.verbose = verbose = false;
+  verbose = false;
   findall = false;
+  nodelimit = 0;
+  aborted = false;
+  showsteps = false;
+  progressinterval = 500;
 }
 
 #define success true
@@ -254,15 +357,27 @@ compiler::compiler(grid &thegrid, walker &thewalker,
 // the reclevel trying to compute this cell catches it
 // and others will return.
 
-timer dtimer;
-
-bool compiler::compile_rest(double rejected) {
+bool compiler::compile_rest(spacecount rejected) {
   int c = w.getcurrent();
+  stats.nodes++;
+  if (nodelimit && stats.nodes > nodelimit) {
+    aborted = true;
+    return failure;
+  }
+  if (searchevents)
+    handleevents();
+  if (w.stepno() > stats.maxdepth)
+    stats.maxdepth = w.stepno();
+  if (tb)
+    tb->add(TRACE_DESCEND, c, w.stepno());
   if (verbose)
     cout << "attempting to find solution for " << c << endl;
+  STAT(long long t0 = hrtime());
   symbolset ss = g(c).findpossible(d);
+  STAT(stats.dictns += hrtime() - t0);
+  STAT(stats.findpossible += g(c).numwords());
   int npossible = numones(ss);
-  rejected += (numalpha-double(npossible)) * pow(numalpha, numcells - w.stepno());
+  rejected.add(numalpha - npossible, numcells - w.stepno());
   if (verbose)
     dumpset(ss);
 
@@ -282,26 +397,39 @@ bool compiler::compile_rest(double rejected) {
   for (; bit; bit=pickbit(ss)) {
     symbol s = symbol::symbolbit(bit);
     g(c).setsymbol(s);
-    if (setup.showallsteps) {
-      g.dump_simple(cout);
-    } else if ((showsteps && dtimer.getmsecs() > 500)) {
+    if (tb)
+      tb->add(TRACE_ASSIGN, c, w.stepno(), s.symbvalue());
+    if (setup.showallsteps)
       g.dump_simple(cout);
-      dtimer.reset();
-    }
     if (w.moresteps()) {
       w.forward();
       if (compile_rest(rejected) == success) return success;
+      if (aborted) {
+	this->rejected = rejected;
+	return failure;
+      }
       if (w.getcurrent() != c) return failure; // catch if ==
       // cout << "continue at " << c << endl;
-      rejected += pow(numalpha, numcells - w.stepno());
+      rejected.add(1, numcells - w.stepno());
     } else {
       this->rejected = rejected;
       return success;
     }
     g(c).setsymbol(symbol::empty);
   }
+  STAT(stats.deadends[c]++);
+  // the first cell's frame returns last, so a failed search ends up
+  // with everything it ruled out
+  this->rejected = rejected;
+  if (tb)
+    tb->add(TRACE_DEADEND, c, w.stepno());
   if (w.stepno() > 1) {
+    stats.backtracks++;
+    int from = w.stepno();
     bt.backtrack(w);
+    STAT(stats.backjump[min(from - w.stepno(), BACKJUMPBUCKETS-1)]++);
+    if (tb)
+      tb->add(TRACE_BACKJUMP, c, w.getcurrent(), 0, 0, 0, from - w.stepno());
     int cur = w.getcurrent();
     if (verbose) 
       cout << "return to " << cur << " from " << c << endl;
@@ -309,22 +437,54 @@ bool compiler::compile_rest(double rejected) {
   return failure;
 }
 
-void compiler::compile() {
-  dtimer.reset(); dtimer.start();
+/**
+ * called from the search when a signal handler has flagged an event.
+ * Progress reports show the current filling and how the search is
+ * advancing since the previous report.
+ */
+
+void compiler::handleevents() {
+  // a signal arriving between a read and a clear would be lost
+  int ev = __sync_lock_test_and_set(&searchevents, 0);
+  if (ev & STATS_EVENT)
+    stats.dump(cerr, false);
+  if ((ev & PROGRESS_EVENT) && showsteps) {
+    long long now = hrtime();
+    double secs = (now - lastreport) / 1e9;
+    cout << "depth " << w.stepno() << " (best " << stats.maxdepth << "), "
+	 << stats.nodes << " nodes, "
+	 << long((stats.nodes - lastreportnodes) / secs) << " nodes/s" << endl;
+    g.dump_simple(cout);
+    lastreport = now;
+    lastreportnodes = stats.nodes;
+  }
+}
+
+bool compiler::compile() {
+  stats.reset();
+  installstatshandler();
+  lastreport = hrtime();
+  lastreportnodes = 0;
+  tb = tracebuf();
+  if (showsteps)
+    startprogresstimer(progressinterval);
   w.forward();
-  numcells = g.numopen();
+  numcells = w.hasregion() ? w.numsteps() : g.numopen();
   numalpha = symbol::numalpha();
-  compile_rest();
+  spacecount::setbase(numalpha, numcells);
+  bool result = compile_rest(spacecount());
+  if (showsteps)
+    stopprogresstimer();
+  return result;
 }
 
 //////////////////////////////////////////////////////////////////////
 // main
 
 void dumpset(symbolset ss) {
-  int i,n;
   cout << '{';
-  for (i=1, n = 0; i; i<<=1, n++) {
-    if (ss&i)
+  for (int n = 0; n < MAXSYMBOLS; n++) {
+    if (hassym(ss, n))
       cout << symbol::alphabet[n];
   }
   cout << '}' << endl;
@@ -340,10 +500,11 @@ void dumpsymbollist(symbol *s, int n) {
   cout << endl;
 }
 
-void trivial_random_init() {
+void trivial_random_init(setup_s &s) {
   struct timeval tv;
   gettimeofday(&tv, 0);
-  srand(tv.tv_usec);
+  s.seed = tv.tv_usec;
+  srand(s.seed);
 }
 
 void random_init(setup_s &s) {
@@ -351,7 +512,7 @@ void random_init(setup_s &s) {
   if (!s.setseed) {
     int fd = open("/dev/random", O_RDONLY);
     if (fd == -1) {
-      trivial_random_init();
+      trivial_random_init(s);
       return;
     }
     if (read(fd, &q, 4) == -1)
@@ -361,6 +522,7 @@ void random_init(setup_s &s) {
     q = s.seed;
   }
   cout << "random seed: " << q << endl;
+  s.seed = q;
   srand(q);
 }
 
@@ -378,6 +540,19 @@ setup_s setup = {
   false,
   0,
   false,
+  "",
+  "",
+  "",
+  setup.nostats,
+  500,
+  false,
+  "",
+  0,
+  "",
+  1,
+  0,
+  -1,
+  false,
 };
 
 char usage[] =
@@ -388,24 +563,80 @@ char usage[] =
 "   -p <filename>     read grid pattern from file\n"
 "   -w <walkertype>   Walking heuristics: prefix or flood\n"
 "   -f <format>       output format, one of `simple' or `ascii'\n"
-"   -i <indextype>    Choose dictionary index style. `btree' or `letter'\n"
+"   -i <indextype>    Choose dictionary index style. `btree', `bitree',\n"
+"                     `letter' or `hybrid'\n"
+"   -D <key=value>    Dictionary option: pairs=1 (letter index position\n"
+"                     pair lists), pairmin=<n>, pairmem=<MB>,\n"
+"                     packed=1 (compressed letter index lists),\n"
+"                     filter=<KB> (letter pair filter ahead of the index),\n"
+"                     overlay=<file> (add words), block=<file> (remove\n"
+"                     words), both repeatable, updates=<file> (apply\n"
+"                     +word/-word lines while solving), liveinterval=<ms>,\n"
+"                     kernels=0 (generic queries instead of the ones\n"
+"                     specialized per word length), prune=1 (load the\n"
+"                     grid first and index only the words it can use),\n"
+"                     threads=<n> (build the index on n threads)\n"
+"   -Q <filename>     record all dictionary queries to file\n"
+"   -T <filename>     write a binary search trace (analyze with cwctrace)\n"
 "   -r seed           Set the random seed\n"
 "   -v                Be verbose - prints algorithmic info\n"
 "   -s                Print the grid filling regularly during compilation\n"
+"   -u <msecs>        Progress report interval for -s (default 500)\n"
 "   -S                Print the grid filling each step\n"
-"   -b                Benchmark dictionaries\n"
+"   -e <probes>       Estimate search tree size and solve time, don't solve\n"
+"   -j <threads>      Solve independent parts of the grid in parallel\n"
+"   -W <width>        Solve by tree decomposition if the grid's width is\n"
+"                     at most <width>, else search as usual\n"
+"   -a <cells>        Compute the dependency degrees from <cells> sampled\n"
+"                     cells only, 0 to skip them (default all cells)\n"
+"   -L                Load the dictionary and the grid at the same time,\n"
+"                     indexing words while the file is read\n"
+"   -P                Profile startup and search phases, time and memory\n"
+"   -H                Add hardware performance counters to -P and -b\n"
+"   -t <format>       Print search statistics, `text' or `json'\n"
+"   -b                Benchmark all dictionary indexes on the -d file\n"
+"   -B <key=value>    Benchmark option: words=<n> (synthetic dictionary),\n"
+"                     lengths=<len:weight,...>, workload=random|known|trace,\n"
+"                     known=<n>, trace=<file>, queries=<n>, seed=<n>,\n"
+"                     out=<file>, seeds=<n>, nodelimit=<n>,\n"
+"                     baseline=<file>, tolerance=<percent>\n"
+"   -c <corpusfile>   Benchmark the solver on a grid corpus (see bench/)\n"
 "   -? -h             Display this help screen\n"
 ;
 
 int parseparameters(int argc, char *argv[]) {
   int c;
-  while (c=getopt(argc, argv, "d:p:vf:hsSw:i:br:g:?"), c != -1) {
+  while (c=getopt(argc, argv, "d:p:vf:hsSw:i:bB:D:c:Q:T:r:g:t:PHu:e:j:W:a:L?"), c != -1) {
     switch (c) {
     case 'g':
       setup.gridfile = optarg; 
       setup.gridformat = setup.generalgrid;
       break;
     case 'b': setup.benchdict = true; break;
+    case 'B': setup.benchopts += string(optarg) + ' '; break;
+    case 'D': setup.dictopts += string(optarg) + ' '; break;
+    case 'Q': setup.querylog = optarg; break;
+    case 'T': setup.tracefile = optarg; break;
+    case 'c': setup.corpusfile = optarg; break;
+    case 'P': profiler.enabled = true; break;
+    case 'H': setup.perfcounters = true; break;
+    case 'e': setup.probes = atoi(optarg); break;
+    case 'j': setup.threads = atoi(optarg); break;
+    case 'W': setup.treewidth = atoi(optarg); break;
+    case 'a': setup.depsample = atoi(optarg); break;
+    case 'L': setup.pipeline = true; break;
+    case 't': {
+      string s(optarg);
+      if (s == "text")
+	setup.statsformat = setup.textstats;
+      else if (s == "json")
+	setup.statsformat = setup.jsonstats;
+      else {
+	puts("Invalid statistics format");
+	return -1;
+      }
+    }
+    break;
     case 'd': setup.dictfile = optarg; break;
     case 'p':
       setup.gridfile = optarg;
@@ -438,11 +669,9 @@ int parseparameters(int argc, char *argv[]) {
     }
     break;
     case 'i': {
-      string s(optarg);
-      if (s=="btree")
-	setup.dictstyle = setup.btreedict;
-      else if (s=="letter")
-	setup.dictstyle = setup.letterdict;
+      dictengine *e = finddictengine(string(optarg));
+      if (e)
+	setup.dictstyle = e->style;
       else {
 	puts("Invalid dictionary index style");
 	return -1;
@@ -450,6 +679,13 @@ int parseparameters(int argc, char *argv[]) {
     }
     break;
     case 's': setup.showsteps = true; break;
+    case 'u':
+      setup.progressinterval = atoi(optarg);
+      if (setup.progressinterval <= 0) {
+	puts("Invalid progress interval");
+	return -1;
+      }
+      break;
     case 'S': setup.showallsteps = true; break;
     case '?':
     case 'h': printf(usage); return -1;
@@ -468,117 +704,210 @@ int main(int argc, char *argv[]) {
 
   try {
 
+    dictopts.parse(setup.dictopts);
     if (setup.benchdict) {
       dodictbench();
       exit(EXIT_SUCCESS);
     }
+    if (!setup.corpusfile.empty())
+      exit(dosolvebench(setup.corpusfile) ? EXIT_FAILURE : EXIT_SUCCESS);
 
-    dict *d = 0;
-    switch(setup.dictstyle) {
-    case setup.btreedict:
-      cout << "Using binary tree index" << endl;
-      d = new btree_dict();
-      break;
-    case setup.letterdict:
-      cout << "Using letter index" << endl;
-      d = new letterdict();
-      break;
+    grid g;
+    dictengine *e = finddictengine(setup.dictstyle);
+    dict *d = e->create(), *base = d;
+    startup *pipe = 0;
+    if (setup.pipeline) {
+      profiler.begin("startup");
+      pipe = new startup(d, g);
+      pipe->run(setup.dictfile);
+    } else if (dictopts.prune) {
+      profiler.begin("grid");
+      loadgrid(g);
+      activescope = new gridscope(g);
+    }
+    if (activescope)
+      cout << "Pruning the dictionary to " << activescope->numlengths()
+	   << " slot lengths and " << activescope->numpatterns()
+	   << " letter patterns" << endl;
+
+    cout << "Using " << e->description << endl;
+    if (pipe) {
+      cout << "Loading wordlist and building dictionary... ok" << endl;
+      cout << pipe->wordsused << " of " << pipe->wordcount
+	   << " words used." << endl;
+    } else
+      d->load(setup.dictfile);
+    d->profilemem();
+    if (!dictopts.overlays.empty() || !dictopts.blocklists.empty()) {
+      profiler.begin("layers");
+      layered_dict *ld = new layered_dict(d);
+      for (unsigned i = 0; i < dictopts.overlays.size(); i++)
+	ld->addoverlay(dictopts.overlays[i]);
+      for (unsigned i = 0; i < dictopts.blocklists.size(); i++)
+	ld->addblocklist(dictopts.blocklists[i]);
+      ld->profilemem();
+      d = ld;
+    }
+    live_dict *live = 0;
+    if (!dictopts.updates.empty()) {
+      if (dictopts.filter > 0 || d != base)
+	throw error("Live updates cannot be combined with filter, overlay or block");
+      live = new live_dict(d, setup.dictfile, e);
+      live->startupdates(dictopts.updates);
+      d = live;
+    }
+    if (dictopts.filter > 0) {
+      profiler.begin("filter");
+      activefilter = new pairfilter(dictopts.filter);
+      vector<string> files(dictopts.overlays);
+      files.push_back(setup.dictfile);
+      activefilter->build(files);
+      profiler.addmem("pair filter", activefilter->memusage());
+    }
+    if (!setup.querylog.empty())
+      d = new querylog_dict(d, setup.querylog);
+    if (!setup.tracefile.empty()) {
+      activetracer = new tracer(setup.tracefile);
+      d = new tracedict(d);
     }
-    d->load(setup.dictfile);
 
-    grid g;
-    if (setup.gridformat == setup.generalgrid)
-      g.load(setup.gridfile);
-    else if (setup.gridformat == setup.squaregrid)
-      g.load_template(setup.gridfile);
+    if (!pipe && !dictopts.prune) {
+      profiler.begin("grid");
+      loadgrid(g);
+    }
     // g.dump_ggrid(cout);
     int nopen = g.numopen();
-    double space = pow(symbol::numalpha(), nopen);
-    cout << nopen << " cells to be filled. " << space << " possible fillings." << endl;
-    walker *w;
-    switch (setup.walkertype) {
-    case setup.prefixwalker:
-      w = new prefix_walker(g);
-      puts("Using prefix walking heuristics");
-      break;
-    case setup.floodwalker:
-      w = new flood_walker(g);
-      puts("Using flood walking heuristics");
-      break;
-    default:
-      puts("Internal error");
-      exit(EXIT_FAILURE);
+    double logspace = nopen * log10(double(symbol::numalpha()));
+    cout << nopen << " cells to be filled. 10^" << logspace << " possible fillings." << endl;
+    componentsolver parts(g, *d);
+    parts.analyze();
+    // independent parts are searched one by one, so their spaces add
+    if (parts.numparts() > 1) {
+      logspace = parts.logspace();
+      cout << "Search space of the independent parts: 10^" << logspace
+	   << " fillings." << endl;
     }
+    walker *w = newwalker(setup.walkertype, g);
+    cout << "Using " << walkernames[setup.walkertype]
+	 << " walking heuristics" << endl;
 
-    cout << "Degree of interlock: " << g.interlockdegree()*100 << "%" << endl;
-    double depdeg1 = g.depencydegree(1);
-    double depdeg2 = g.depencydegree(2);
-    cout << "Degree of depency: " << depdeg1 << '(' << (depdeg1*100.0/nopen) << "%)" << endl;
-    cout << "Degree of 2nd level depency: " << depdeg2 << '(' << (depdeg2*100.0/nopen) << "%)" << endl;
+    profiler.addmem("grid", g.memusage());
 
+    profiler.begin("analysis");
+    gridanalysis ga;
+    if (pipe)
+      ga = pipe->analysis;
+    else
+      ga.run(g);
+    cout << "Degree of interlock: " << ga.interlock*100 << "%" << endl;
+    if (setup.depsample != 0) {
+      double depdeg1 = ga.depdeg1, depdeg2 = ga.depdeg2;
+      const char *sampled = setup.depsample > 0 ? " (sampled)" : "";
+      cout << "Degree of depency: " << depdeg1 << '(' << (depdeg1*100.0/nopen) << "%)" << sampled << endl;
+      cout << "Degree of 2nd level depency: " << depdeg2 << '(' << (depdeg2*100.0/nopen) << "%)" << sampled << endl;
+    }
+    if (parts.numparts() > 1) {
+      cout << "Independent parts: " << parts.numparts() << " (";
+      for (int p = 0; p < parts.numparts(); p++)
+	cout << (p ? ", " : "") << parts.partsize(p);
+      cout << " cells)" << endl;
+    }
+    treesolver tree(g, *d);
+    bool usetree = false;
+    if (setup.treewidth > 0) {
+      usetree = tree.decompose(setup.treewidth);
+      if (usetree)
+	cout << "Tree decomposition: width " << tree.width() << ", "
+	     << tree.numtrees() << " trees" << endl;
+      else
+	cout << "Tree decomposition: width above " << setup.treewidth
+	     << ", using backtracking" << endl;
+    }
+
+    if (setup.probes > 0) {
+      profiler.begin("estimate");
+      estimator est(g, *w, *d);
+      est.run(setup.probes, cout);
+      profiler.end();
+      profiler.report(cout);
+      exit(EXIT_SUCCESS);
+    }
+
+    if (setup.threads > 1 && !setup.querylog.empty())
+      throw error("The query log cannot be written by parallel threads");
     smart_backtracker bt(g);
     
     compiler c(g, *w, bt, *d);
+    c.stats.engine = e->name;
     c.verbose = setup.verbose;
     c.showsteps = setup.showsteps;
+    c.progressinterval = setup.progressinterval;
+    parts.engine = e->name;
+    parts.verbose = setup.verbose;
+    parts.showsteps = setup.showsteps;
+    parts.progressinterval = setup.progressinterval;
+    parts.seed = setup.seed;
+    tree.nodelimit = c.nodelimit;
+    tree.showsteps = setup.showsteps;
+    tree.progressinterval = setup.progressinterval;
+    bool split = parts.numparts() > 1;
+    struct solve : solvetask {
+      treesolver *tree; componentsolver *parts; compiler *c;
+      bool usetree, split;
+      void run() {
+	if (usetree)
+	  tree->solve();
+	else if (split)
+	  parts->solve(setup.walkertype, setup.threads);
+	else
+	  c->compile();
+      }
+    } job;
+    job.tree = &tree; job.parts = &parts; job.c = &c;
+    job.usetree = usetree; job.split = split;
+    profiler.begin("solve");
     timer t; t.start();
-    c.compile();
+    runwithstack(job, nopen);
     t.stop();
     
+    profiler.begin("output");
     g.dump(cout, setup.output_format);
     cout << "Attempt average: " << g.attemptaverage() << endl;
     cout << "Compilation time: " << t.getmsecs() << " msecs" << endl;
-    double searched = c.getrejected();
-    cout << searched << " solutions searched. " << (searched*100/space) << "% of search space." << endl;
+    searchstats &stats = usetree ? tree.stats : split ? parts.stats : c.stats;
+    if (setup.statsformat != setup.nostats)
+      stats.dump(cout, setup.statsformat == setup.jsonstats);
+    if (usetree) {
+      cout << "Tree search: " << tree.stats.nodes << " nodes, "
+	   << tree.contexts << " contexts solved, " << tree.cachehits
+	   << " cache hits" << endl;
+    } else {
+      double logsearched = (split ? parts.rejected : c.getrejected()).log10();
+      if (logsearched == -HUGE_VAL)
+	cout << "0 solutions searched. 0% of search space." << endl;
+      else
+	cout << "10^" << logsearched << " solutions searched. " << (pow(10, logsearched - logspace)*100) << "% of search space." << endl;
+    }
+    profiler.end();
+    profiler.report(cout);
+    if (activetracer) {
+      activetracer->close();
+      if (activetracer->stalls)
+	cout << "trace writer stalled the search " << activetracer->stalls
+	     << " times" << endl;
+    }
+    if (live) {
+      live->stopupdating();
+      cout << "live updates: " << live->added << " added, " << live->removed
+	   << " removed, " << live->publications << " publications, "
+	   << live->merges << " merges" << endl;
+    }
+    if (activefilter)
+      cout << "pair filter rejected " << activefilter->rejects << " of "
+	   << activefilter->probes << " cells" << endl;
+    delete d;
   } catch (error e) {
     cout << e.what() << endl;
     exit(EXIT_FAILURE);
   }
 }
-
-void dodictbench() {
-  int t1, t2;
-
-  btree_dict bd;
-  bd.load("/usr/dict/words");
-  t1 = dictbench(bd);
-
-  letterdict d2; 
-  d2.load("/usr/dict/words");
-  t2 = dictbench(d2);
-  
-  cout << "btree=" << t1 << ", letter=" << t2 << endl;
-}
-
-int dictbench(dict &d) {
-  symbol s[MAXWORDLEN];
-  int o[MAXWORDLEN];
-
-  timer t; t.start();
-
-  for (int r=0; r<100; r++) {
-    for (int i=0;i<MAXWORDLEN;i++)
-      o[i] = i;
-
-    for (int len = 1; len < MAXWORDLEN; len++) {
-      for (int i=0;i<len;i++) {
-	s[i] = symbol::empty;
-	// shuffle
-	int q = rand()%len;
-	int t = o[q]; o[q] = o[i]; o[i] = t;
-      }
-      int n = 0;
-      int pos = o[n++];
-      while (n <= len) {
-	symbolset ss = d.findpossible(s, len, pos);
-	if (!ss) break;
-	s[pos] = symbol::symbolbit(pickbit(ss));
-	pos = o[n++];
-      }
-    }
-  }
-
-  t.stop();
-
-  return t.getticks();
-}
@@ -18,6 +18,9 @@
  **/
 
 #include "main.hh"
+#include "stats.hh"
+#include "trace.hh"
+#include "estimate.hh"
 
 //////////////////////////////////////////////////////////////////////
 
@@ -26,12 +29,19 @@ class backtracker;
 class walker {
 protected:
   vector<int> cellno;
+  vector<int> stepof;   // index of a cell in cellno, -1 if not there
   int current;
   grid &g;
 
   bool current_oneof(int *no, int n);
   int limit;
   bool inited;
+  vector<bool> region;  // the cells to fill, all empty cells if none
+  vector<int> regioncells;  // the same cells, in order
+  bool inregion(int c) {
+    return region.empty() || ((c >= 0) && (unsigned(c) < region.size())
+			      && region[c]);
+  }
   
 public:
   walker(grid &thegrid);
@@ -44,6 +54,12 @@ public:
   void forward();
   void backward(bool savepreferred = false);
   int stepno() { return cellno.size() + 1; }
+  // fill only the given empty cells (sorted), before the first
+  // forward(); a walker may be given one region after another
+  void setregion(const vector<int> &cells);
+  int after(int c);
+  bool hasregion() { return !region.empty(); }
+  int numsteps() { return limit; }
 
 protected:
   /**
@@ -66,6 +82,14 @@ protected:
    * find the first free cell in the grid.
    */
   virtual void findnext();
+  /**
+   * called by backward() after cell c was emptied.
+   */
+  virtual void cleared(int c) {}
+  /**
+   * called by setregion() when a new walk begins.
+   */
+  virtual void restart() {}
 public:
   bool moresteps();
 };
@@ -79,12 +103,19 @@ protected:
 };
 
 class flood_walker : public walker {
+  // the cells of cellno before first have no empty slot neighbour
+  unsigned first;
 public:
   flood_walker(grid &g);
 protected:
   void step_forward();
+  void cleared(int c);
+  void restart() { first = 0; }
 };
 
+extern const char *walkernames[];
+walker *newwalker(setup_s::walker_t type, grid &g);
+
 //////////////////////////////////////////////////////////////////////
 
 class backtracker {
@@ -121,20 +152,27 @@ class compiler {
 protected:
   int numcells;
   int numalpha;
-  double rejected;
+  spacecount rejected;
+  bool aborted;
   grid &g;
   walker &w;
   backtracker &bt;
   dict &d;
-  bool compile_rest(double rejected = 0);
+  bool compile_rest(spacecount rejected);
+  long long lastreport;
+  long lastreportnodes;
+  void handleevents();
+  tracebuffer *tb;
 public:
   compiler(grid &thegrid, walker &thewalker, backtracker &thebacktracker, dict &thedict);
-  void compile();
+  bool compile();
   
   bool verbose, findall, showsteps;
-  double getrejected() { return rejected; }
-};
+  long nodelimit; // give up after this many nodes, 0 = never
+  int progressinterval; // msecs between progress reports
+  spacecount getrejected() { return rejected; }
 
-void dodictbench();
-int dictbench(dict &d);
+  searchstats stats;
+  bool wasaborted() { return aborted; }
+};
 
@@ -0,0 +1,142 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+/**
+ * cwctrace - offline analysis of binary search traces written by
+ * cwc -T. Reports the shape of the search tree, the cells where the
+ * search spends its time and dies, backjump distances and how often
+ * the same dictionary query is repeated.
+ *
+ * Usage: cwctrace <tracefile>
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <iostream.h>
+#include <vector>
+#include <map>
+#include <algo.h>
+
+#include "trace.hh"
+
+struct countorder {
+  bool operator()(const pair<long, long> &a, const pair<long, long> &b) const {
+    return a.first > b.first;
+  }
+};
+
+static void top(const char *title, map<long, long> &m, int n) {
+  vector< pair<long, long> > v;
+  for (map<long, long>::iterator i = m.begin(); i != m.end(); i++)
+    v.push_back(pair<long, long>((*i).second, (*i).first));
+  sort(v.begin(), v.end(), countorder());
+  cout << title << ':';
+  for (int i = 0; i < n && unsigned(i) < v.size(); i++)
+    cout << ' ' << v[i].second << '(' << v[i].first << ')';
+  cout << endl;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    cerr << "Usage: cwctrace <tracefile>" << endl;
+    return 1;
+  }
+  FILE *f = fopen(argv[1], "rb");
+  char magic[8];
+  if ((f == 0) || (fread(magic, 1, 8, f) != 8) ||
+      memcmp(magic, TRACE_MAGIC, 8) != 0) {
+    cerr << "Not a cwc trace: " << argv[1] << endl;
+    return 1;
+  }
+
+  long bytype[TRACE_QUERY + 1];
+  for (int i = 0; i <= TRACE_QUERY; i++) bytype[i] = 0;
+  vector<long> perdepth, jumps;
+  map<long, long> visits, deadends, signatures;
+  long emptyqueries = 0;
+  unsigned int threads = 0;
+
+  tracechunk hdr;
+  vector<traceevent> ev(TRACE_CHUNKEVENTS);
+  while (fread(&hdr, sizeof(hdr), 1, f) == 1) {
+    if ((hdr.nevents > TRACE_CHUNKEVENTS) ||
+	(fread(&ev[0], sizeof(traceevent), hdr.nevents, f) != hdr.nevents)) {
+      cerr << "Truncated trace" << endl;
+      break;
+    }
+    if (hdr.thread >= threads) threads = hdr.thread + 1;
+    for (unsigned i = 0; i < hdr.nevents; i++) {
+      traceevent &e = ev[i];
+      if ((e.type < TRACE_DESCEND) || (e.type > TRACE_QUERY))
+	continue;
+      bytype[e.type]++;
+      switch (e.type) {
+      case TRACE_DESCEND:
+	if (unsigned(e.arg) >= perdepth.size()) perdepth.resize(e.arg + 1, 0);
+	perdepth[e.arg]++;
+	visits[e.cell]++;
+	break;
+      case TRACE_DEADEND:
+	deadends[e.cell]++;
+	break;
+      case TRACE_BACKJUMP:
+	if (e.extra >= jumps.size()) jumps.resize(e.extra + 1, 0);
+	jumps[e.extra]++;
+	break;
+      case TRACE_QUERY:
+	signatures[e.extra]++;
+	if (e.arg == 0) emptyqueries++;
+	break;
+      }
+    }
+  }
+  fclose(f);
+
+  cout << "threads: " << threads << endl;
+  cout << "events: descend " << bytype[TRACE_DESCEND] << ", assign "
+       << bytype[TRACE_ASSIGN] << ", deadend " << bytype[TRACE_DEADEND]
+       << ", backjump " << bytype[TRACE_BACKJUMP] << ", query "
+       << bytype[TRACE_QUERY] << endl;
+
+  cout << "tree: max depth " << (perdepth.empty() ? 0 : perdepth.size() - 1);
+  if (bytype[TRACE_DESCEND])
+    cout << ", " << double(bytype[TRACE_ASSIGN]) / bytype[TRACE_DESCEND]
+	 << " assignments per node";
+  cout << endl << "nodes per depth:";
+  for (unsigned d = 0; d < perdepth.size(); d++)
+    if (perdepth[d]) cout << ' ' << d << ':' << perdepth[d];
+  cout << endl;
+
+  top("hot cells", visits, 10);
+  top("dead end cells", deadends, 10);
+
+  cout << "backjump distance:";
+  for (unsigned d = 0; d < jumps.size(); d++)
+    if (jumps[d]) cout << ' ' << d << ':' << jumps[d];
+  cout << endl;
+
+  long nq = bytype[TRACE_QUERY];
+  if (nq) {
+    cout << "queries: " << nq << ", " << signatures.size()
+	 << " distinct patterns, " << 100.0 * (nq - signatures.size()) / nq
+	 << "% repeated, " << 100.0 * emptyqueries / nq << "% empty" << endl;
+    top("most repeated pattern signatures", signatures, 5);
+  }
+  return 0;
+}
@@ -17,19 +17,38 @@
  * 02111-1307, USA. 
  **/
 
+#include <pthread.h>
 #include <string>
 #include <fstream>
+#include <vector>
+#include <algo.h>
 
 #include "symbol.hh"
 #include "dict.hh"
+#include "profile.hh"
+#include "engines.hh"
+#include "kernels.hh"
+#include "gridscope.hh"
 
 //////////////////////////////////////////////////////////////////////
 // class symbollink
 
 int symbollink::instancecount = 0;
 
-symbollink::symbollink() : symb(symbol::outside), target(0), next(0) {
-  instancecount++;
+symbollink::symbollink()
+  : symb(symbol::outside), target(0), next(0), reach(0) {
+  __sync_fetch_and_add(&instancecount, 1);
+}
+
+symbollink::~symbollink() {
+  symbollink *sl = target;
+  while (sl != 0) {
+    symbollink *next = sl->next;
+    delete sl;
+    sl = next;
+  }
+  delete[] reach;
+  __sync_fetch_and_sub(&instancecount, 1);
 }
 
 symbollink *symbollink::addlink(symbol s) {
@@ -42,7 +61,7 @@ symbollink *symbollink::addlink(symbol s) {
 
 void symbollink::addword(symbol *str, int n) {
   if (n == 0) return;
-  if (!isalpha(str[0]))
+  if (!wordchar(str[0]))
     throw error("!!!");
   symbollink *sl = getlink(str[0]);
   if (sl == 0)
@@ -57,6 +76,31 @@ symbollink *symbollink::getlink(symbol s) {
   return 0;
 }
 
+/**
+ * computes the reach masks of this node and all nodes below it.
+ * depth is the number of symbols below this node.
+ */
+
+void symbollink::buildreach(int depth) {
+  delete[] reach;
+  reach = 0;
+  if (depth == 0) return;
+  reach = new symbolset[depth];
+  for (int d = 0; d < depth; d++) reach[d] = 0;
+  for (symbollink *sl = target; sl != 0; sl = sl->next) {
+    sl->buildreach(depth-1);
+    reach[0] |= sl->symb.getsymbolset();
+    for (int d = 1; sl->reach && d < depth; d++)
+      reach[d] |= sl->reach[d-1];
+  }
+}
+
+/**
+ * ORs into ss the symbols possible at pos. Above pos the return value
+ * is not used, so subtrees that cannot add to ss are skipped; below
+ * pos only the existence of a matching word matters.
+ */
+
 bool symbollink::findpossible(symbol *s, int len,
 				   int pos, symbolset &ss) {
   if ((target == 0)&&(len==0)) {
@@ -67,16 +111,30 @@ bool symbollink::findpossible(symbol *s, int len,
   if ((target==0)||(len==0))
     return false;
 
+  if (reach) {
+    if ((pos >= 0) && (reach[pos] & ~ss) == 0)
+      return false;
+    for (int i = 0; i < len; i++)
+      if ((s[i] != symbol::empty) && (reach[i] & s[i].getsymbolset()) == 0)
+	return false;
+  }
+
   if (s[0] == symbol::empty) {
     // search each subtree and OR the result.
     bool atallany = false;
     for (symbollink *sl = target; sl != 0; sl = sl->next) {
+      if ((pos == 0) && (ss & sl->symb.getsymbolset()))
+	continue;
       bool any = sl->findpossible(s+1, len-1, pos-1, ss);
       if (any) {
 	atallany = true;
         if (pos==0)
 	  ss |= sl->symb.getsymbolset();
+	else if (pos < 0)
+	  return true;
       }
+      if ((pos > 0) && reach && (reach[pos] & ~ss) == 0)
+	break;
     }
     return atallany;
   } else {
@@ -95,6 +153,26 @@ bool symbollink::findpossible(symbol *s, int len,
   }
 }
 
+long symbollink::countwords(symbol *s, int len, long limit) {
+  if ((target == 0)&&(len==0))
+    return 1;
+  if ((target==0)||(len==0))
+    return 0;
+  if (reach)
+    for (int i = 0; i < len; i++)
+      if ((s[i] != symbol::empty) && (reach[i] & s[i].getsymbolset()) == 0)
+	return 0;
+
+  if (s[0] != symbol::empty) {
+    symbollink *sl = getlink(s[0]);
+    return sl ? sl->countwords(s+1, len-1, limit) : 0;
+  }
+  long n = 0;
+  for (symbollink *sl = target; sl != 0 && n < limit; sl = sl->next)
+    n += sl->countwords(s+1, len-1, limit - n);
+  return n;
+}
+
 void symbollink::dump(char *prefix, int len) {
   if (target == 0) {
     cout << prefix << symb << endl;
@@ -116,6 +194,96 @@ void symbollink::dump(char *prefix, int len) {
     prefix[--len] = '\0';
   }
 }
+long symbollink::reachbytes(int depth) {
+  long n = reach ? depth * sizeof(symbolset) : 0;
+  for (symbollink *sl = target; sl; sl = sl->next)
+    n += sl->reachbytes(depth-1);
+  return n;
+}
+
+int symbollink::countnodes() {
+  int n = 1;
+  for (symbollink *sl = target; sl; sl = sl->next)
+    n += sl->countnodes();
+  return n;
+}
+
+//////////////////////////////////////////////////////////////////////
+// parallel index builds
+
+struct lengthjob {
+  void (*job)(void *, int);
+  void *arg;
+  vector<int> lens;
+  string err;
+};
+
+static void *lengthworker(void *a) {
+  lengthjob *j = (lengthjob*)a;
+  try {
+    for (unsigned i = 0; i < j->lens.size(); i++)
+      j->job(j->arg, j->lens[i]);
+  } catch (error e) {
+    j->err = e.what();
+  }
+  return 0;
+}
+
+struct heavier {
+  const vector<long> *weight;
+  bool operator()(int a, int b) const {
+    return (*weight)[a] != (*weight)[b] ? (*weight)[a] > (*weight)[b] : a < b;
+  }
+};
+
+void forlengths(void (*job)(void *, int), void *arg,
+		const vector<long> &weight) {
+  vector<int> lens;
+  for (unsigned len = 0; len < weight.size(); len++)
+    if (weight[len] > 0)
+      lens.push_back(len);
+  int threads = dictopts.threads;
+  if (threads > int(lens.size())) threads = lens.size();
+  if (threads <= 1) {
+    for (unsigned i = 0; i < lens.size(); i++)
+      job(arg, lens[i]);
+    return;
+  }
+
+  // heaviest first, each to the least loaded thread
+  heavier cmp;
+  cmp.weight = &weight;
+  sort(lens.begin(), lens.end(), cmp);
+  vector<lengthjob> jobs(threads);
+  vector<long> load(threads, 0);
+  for (unsigned i = 0; i < lens.size(); i++) {
+    int t = min_element(load.begin(), load.end()) - load.begin();
+    jobs[t].lens.push_back(lens[i]);
+    load[t] += weight[lens[i]];
+  }
+  vector<pthread_t> tids(threads);
+  for (int t = 0; t < threads; t++) {
+    jobs[t].job = job;
+    jobs[t].arg = arg;
+  }
+  int started = 1;
+  while (started < threads &&
+	 pthread_create(&tids[started], 0, lengthworker, &jobs[started]) == 0)
+    started++;
+  if (started < threads) {
+    // the running threads use jobs, so they finish before it goes
+    for (int t = 1; t < started; t++)
+      pthread_join(tids[t], 0);
+    throw error("Failed to start index thread");
+  }
+  lengthworker(&jobs[0]);
+  for (int t = 1; t < threads; t++)
+    pthread_join(tids[t], 0);
+  for (int t = 0; t < threads; t++)
+    if (!jobs[t].err.empty())
+      throw error(jobs[t].err);
+}
+
 //////////////////////////////////////////////////////////////////////
 // dict
 
@@ -125,10 +293,120 @@ dict::dict() {
 dict::~dict() {
 }
 
+void dict::loadwords(const vector<string> &) {
+  throw error("Dictionary index cannot be built from a word list");
+}
+
+void dict::addwords(const vector<string> &words) {
+  pending.insert(pending.end(), words.begin(), words.end());
+}
+
+void dict::finishwords() {
+  vector<string> words;
+  words.swap(pending);
+  loadwords(words);
+}
+
+long dict::countwords(symbol *, int, long) {
+  throw error("Dictionary index does not support word counts");
+}
+
+long dict::memusage() {
+  return 0;
+}
+
+void dict::profilemem() {
+  profiler.addmem("dictionary index", memusage());
+}
+
+//////////////////////////////////////////////////////////////////////
+// trie kernels
+
+/**
+ * symbollink::findpossible for a word length known at compile time.
+ * need holds the pattern packed into one symbol set per position, 0
+ * where the letter is open, so the reach test is a mask test per
+ * position and unrolls.
+ */
+
+template<int LEN>
+static bool triekernel(symbollink *n, symbol *s, const symbolset *need,
+		       int pos, symbolset &ss);
+
+template<>
+bool triekernel<0>(symbollink *n, symbol *, const symbolset *,
+		   int pos, symbolset &ss) {
+  if (n->target != 0)
+    return false;
+  if (pos == 0)
+    ss |= n->symb.getsymbolset();
+  return true;
+}
+
+template<int LEN>
+static bool triekernel(symbollink *n, symbol *s, const symbolset *need,
+		       int pos, symbolset &ss) {
+  if (n->target == 0)
+    return false;
+  symbolset *reach = n->reach;
+  if (reach) {
+    if ((pos >= 0) && (reach[pos] & ~ss) == 0)
+      return false;
+    for (int i = 0; i < LEN; i++)
+      if ((need[i] != 0) && (reach[i] & need[i]) == 0)
+	return false;
+  }
+
+  if (need[0] != 0) {
+    symbollink *sl = n->getlink(s[0]);
+    if (sl == 0 || !triekernel<LEN-1>(sl, s+1, need+1, pos-1, ss))
+      return false;
+    if (pos == 0)
+      ss |= sl->symb.getsymbolset();
+    return true;
+  }
+
+  bool atallany = false;
+  for (symbollink *sl = n->target; sl != 0; sl = sl->next) {
+    symbolset b = sl->symb.getsymbolset();
+    if ((pos == 0) && (ss & b))
+      continue;
+    if (triekernel<LEN-1>(sl, s+1, need+1, pos-1, ss)) {
+      atallany = true;
+      if (pos == 0)
+	ss |= b;
+      else if (pos < 0)
+	return true;
+    }
+    if ((pos > 0) && reach && (reach[pos] & ~ss) == 0)
+      break;
+  }
+  return atallany;
+}
+
+struct triekernels {
+  typedef symbolset (*kernel)(symbollink &root, symbol *s, int pos);
+  template<int LEN> static symbolset run(symbollink &root, symbol *s,
+					 int pos) {
+    symbolset need[LEN + 1];
+    for (int i = 0; i < LEN; i++)
+      need[i] = (s[i] == symbol::empty) ? symbolset(0) : s[i].getsymbolset();
+    symbolset ss = 0;
+    triekernel<LEN>(&root, s, need, pos, ss);
+    return ss;
+  }
+};
+
+static triekernels::kernel trietable[MAXWORDLEN];
+
 //////////////////////////////////////////////////////////////////////
 // btree_dict
 
-btree_dict::btree_dict() : primary() {
+btree_dict::btree_dict() : primary(), kernels(true) {
+  for (int i=0;i<256;i++) chset[i] = false;
+  for (int len = 0; len < MAXWORDLEN; len++) lencount[len] = 0;
+  if (trietable[0] == 0)
+    kernelfill<triekernels, MAXWORDLEN-1>::fill(trietable);
 }
 
 void btree_dict::addword(symbol *str, int n) {
@@ -141,57 +419,155 @@ int btree_dict::size() {
 
 void btree_dict::load(const string &fn) {
   cout << "Loading wordlist and building dictionary... " << flush;
-  bool chset[256];
-  for (int i=0;i<256;i++) chset[i] = false;
+  profiler.begin("load");
 
   ifstream f(fn.c_str());
   if (!f.is_open()) throw error("Failed to open dictionary file");
   char sz[256];
-  int wordcount = 0, wordsused = 0;
+  int wordcount = 0;
+  vector<string> words;
   while (f.getline(sz, 256), !f.eof()) {
     wordcount++;
     int wlen = strlen(sz);
-    if (sz[wlen-1]=='\n')
+    if (wlen && sz[wlen-1]=='\n')
       sz[--wlen] = '\0';
 
     bool ok = true;
     for (int i=0;i<wlen;i++) {
       sz[i] = tolower(sz[i]);
-      if (!isalpha(sz[i])) {
+      if (!wordchar(sz[i])) {
 	ok = false;
       }
     }
+    if (ok && activescope && !activescope->allows(sz))
+      ok = false;
     if (ok) {
-      symbol *symbs = new symbol[wlen];
-      for (int i=0;i<wlen;i++) {
-	symbs[i] = sz[i];
-	chset[(unsigned char)sz[i]] = true;
-      }
-      addword(symbs, wlen);
-      wordsused++;
-      delete[] symbs;
+      words.push_back(sz);
     } else {
       // cout << "rejecting " << sz << endl;
     }
     
   }
+
+  profiler.begin("index");
+  loadwords(words);
+  cout << "ok" << endl;
+  cout << words.size() << " of " << wordcount << " words used." << endl;
+}
+
+void btree_dict::loadwords(const vector<string> &words) {
+  addwords(words);
+  finishwords();
+}
+
+struct trieinsert {
+  btree_dict *d;
+  const vector<string> *words;
+  vector<vector<int> > bylen;      // word numbers of each length
+};
+
+static void insertlength(void *arg, int len) {
+  trieinsert *ti = (trieinsert*)arg;
+  symbol symbs[MAXWORDLEN];
+  vector<int> &ws = ti->bylen[len];
+  for (unsigned n = 0; n < ws.size(); n++) {
+    const string &w = (*ti->words)[ws[n]];
+    for (int i = 0; i < len; i++)
+      symbs[i] = w[i];
+    ti->d->addword(symbs, len);
+  }
+}
+
+/**
+ * adds words to the tries. The symbols are allocated first, in word
+ * order; then the words of each length are inserted in order, the
+ * lengths spread over the index build threads.
+ */
+
+void btree_dict::addwords(const vector<string> &words) {
+  int nwords = words.size();
+  trieinsert ti;
+  ti.d = this;
+  ti.words = &words;
+  ti.bylen.resize(MAXWORDLEN);
+  vector<long> weight(MAXWORDLEN, 0);
+  for (int n = 0; n < nwords; n++) {
+    int wlen = words[n].length();
+    for (int i=0;i<wlen;i++) {
+      // allocates the letter's symbol; the cast keeps this an expression
+      (void)symbol(words[n][i]);
+      chset[(unsigned char)words[n][i]] = true;
+    }
+    if (wlen >= MAXWORDLEN) continue;     // fits no trie
+    ti.bylen[wlen].push_back(n);
+    weight[wlen] += wlen;
+    lencount[wlen]++;
+  }
+  forlengths(insertlength, &ti, weight);
+}
+
+// builds the reach masks of one trie of an array of tries by length
+void btree_dict::reachlength(void *tries, int len) {
+  ((symbollink*)tries)[len].buildreach(len);
+}
+
+void btree_dict::finishwords() {
   for (int i=0;i<256;i++) {
     if (chset[i]) {
       symbol s[1];
       s[0] = i;
       addword(s, 1);
+      lencount[1]++;
     }
   }
-  cout << "ok" << endl;
-  cout << wordsused << " of " << wordcount << " words used." << endl;
+  forlengths(reachlength, primary, reachweight());
+  kernels = dictopts.kernels;
 }
 
-symbolset btree_dict::findpossible(symbol *s, int len, int pos) {
+// the reach build cost of each length, at least 1 so all are built
+vector<long> btree_dict::reachweight() {
+  vector<long> weight(MAXWORDLEN);
+  for (int len = 0; len < MAXWORDLEN; len++)
+    weight[len] = 1 + lencount[len] * len;
+  return weight;
+}
+
+symbolset btree_dict::findtrie(symbollink &root, symbol *s, int len, int pos) {
+  if (kernels)
+    return trietable[len](root, s, pos);
   symbolset ss = 0;
-  primary[len].findpossible(s, len, pos, ss);
+  root.findpossible(s, len, pos, ss);
   return ss;
 }
 
+symbolset btree_dict::findpossible(symbol *s, int len, int pos) {
+  return findtrie(primary[len], s, len, pos);
+}
+
+long btree_dict::countwords(symbol *s, int len, long limit) {
+  return primary[len].countwords(s, len, limit);
+}
+
+long btree_dict::memusage() {
+  long n = 0;
+  for (int i = 0; i < MAXWORDLEN; i++)
+    n += primary[i].countnodes();
+  return n * sizeof(symbollink) + reachbytes();
+}
+
+long btree_dict::reachbytes() {
+  long n = 0;
+  for (int i = 0; i < MAXWORDLEN; i++)
+    n += primary[i].reachbytes(i);
+  return n;
+}
+
+void btree_dict::profilemem() {
+  long r = reachbytes();
+  profiler.addmem("trie nodes", memusage() - r);
+  profiler.addmem("trie reach masks", r);
+}
+
 void btree_dict::dump(int len) {
   primary[len].dump();
 }
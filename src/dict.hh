@@ -20,37 +20,89 @@
 #ifndef DICT_HH
 #define DICT_HH
 
+#include <vector>
+
 //////////////////////////////////////////////////////////////////////
 
+/**
+ * A trie node. reach[d] holds the symbols that occur d levels below
+ * the children of the node, which lets findpossible skip subtrees
+ * that cannot match the known letters or cannot add new symbols.
+ */
+
 struct symbollink {
   symbol symb;
   static int instancecount;
   symbollink *target, *next;
+  symbolset *reach;
   symbollink *getlink(symbol);
   symbollink();
+  ~symbollink();
   symbollink *addlink(symbol);
   void addword(symbol *, int);
+  void buildreach(int depth);
   bool findpossible(symbol *s, int len, int pos, symbolset &ss);
+  long countwords(symbol *s, int len, long limit);
   void dump(char *prefix = 0, int len = 0);
+  int countnodes();
+  long reachbytes(int depth);
 };
 
+/**
+ * runs job(arg, len) for every word length with a weight above zero,
+ * on the -D threads=<n> index build threads. A length is always done
+ * by one thread, so the jobs of different lengths share nothing and
+ * the result does not depend on the number of threads.
+ */
+
+void forlengths(void (*job)(void *, int), void *arg,
+		const vector<long> &weight);
+
 class dict {
 public:
   dict();
   virtual ~dict();
 
   virtual void load(const string &fn) = 0;
+  // build the index from words in memory, without reporting
+  virtual void loadwords(const vector<string> &words);
+  // the same in steps, as batches of words arrive; by default the
+  // batches are gathered and given to loadwords at the end
+  virtual void addwords(const vector<string> &words);
+  virtual void finishwords();
   virtual symbolset findpossible(symbol *s, int len, int pos) = 0;
+  // number of words matching s, counting stops at limit
+  virtual long countwords(symbol *s, int len, long limit);
+  // approximate number of bytes held by the index
+  virtual long memusage();
+  // register the index structures with the phase profiler
+  virtual void profilemem();
+protected:
+  vector<string> pending;
 };
 
 class btree_dict : public dict {
   symbollink primary[MAXWORDLEN];
+  bool kernels;       // use the per-length query kernels
+  bool chset[256];    // characters seen, added as one letter words
+protected:
+  long lencount[MAXWORDLEN];   // words of each length
+  symbolset findtrie(symbollink &root, symbol *s, int len, int pos);
+  vector<long> reachweight();
+  static void reachlength(void *tries, int len);
 public:
   btree_dict();
-  void addword(symbol *, int);
+  virtual void addword(symbol *, int);
   void load(const string &fn);
+  void loadwords(const vector<string> &words);
+  void addwords(const vector<string> &words);
+  void finishwords();
   int size();
   symbolset findpossible(symbol *s, int len, int pos);
+  long countwords(symbol *s, int len, long limit);
+  long memusage();
+  long reachbytes();
+  void profilemem();
   void dump(int len);
 };
 
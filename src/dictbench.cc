@@ -0,0 +1,410 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <iostream.h>
+#include <fstream.h>
+#include <strstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <algo.h>
+
+#include "timer.hh"
+#include "perfcount.hh"
+#include "symbol.hh"
+#include "dict.hh"
+#include "engines.hh"
+#include "wordlist.hh"
+#include "dictbench.hh"
+
+//////////////////////////////////////////////////////////////////////
+// benchparams
+
+benchparams::benchparams()
+  : words(0), lengths(""), workload("random"), known(3), trace(""),
+    queries(20000), seed(1), out(""), seeds(5), nodelimit(2000000),
+    baseline(""), tolerance(10) {
+}
+
+void benchparams::parse(const string &opts) {
+  istrstream is(opts.c_str());
+  string kv;
+  while (is >> kv) {
+    string::size_type eq = kv.find('=');
+    if (eq == string::npos)
+      throw error("Benchmark option must be key=value: " + kv);
+    string key = kv.substr(0, eq), val = kv.substr(eq + 1);
+    if (key == "words") words = atoi(val.c_str());
+    else if (key == "lengths") lengths = val;
+    else if (key == "workload") workload = val;
+    else if (key == "known") known = atoi(val.c_str());
+    else if (key == "trace") { trace = val; workload = "trace"; }
+    else if (key == "queries") queries = atoi(val.c_str());
+    else if (key == "seed") seed = atoi(val.c_str());
+    else if (key == "out") out = val;
+    else if (key == "seeds") seeds = atoi(val.c_str());
+    else if (key == "nodelimit") nodelimit = atol(val.c_str());
+    else if (key == "baseline") baseline = val;
+    else if (key == "tolerance") tolerance = atoi(val.c_str());
+    else throw error("Unknown benchmark option: " + key);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+// class querylog_dict
+
+querylog_dict::querylog_dict(dict *inner, const string &fn)
+  : d(*inner), f(fn.c_str()) {
+  if (!f.is_open()) throw error("Failed to open query log");
+}
+
+querylog_dict::~querylog_dict() {
+  delete &d;
+}
+
+symbolset querylog_dict::findpossible(symbol *s, int len, int pos) {
+  for (int i = 0; i < len; i++) {
+    if (s[i] == symbol::empty)
+      f << '-';
+    else
+      f << s[i];
+  }
+  f << ' ' << pos << '\n';
+  return d.findpossible(s, len, pos);
+}
+
+//////////////////////////////////////////////////////////////////////
+// synthetic dictionaries
+
+// relative letter frequencies of english text, a-z
+static int letterfreq[26] = {
+  82, 15, 28, 43, 127, 22, 20, 61, 70, 2, 8, 40, 24,
+  67, 75, 19, 1, 60, 63, 91, 28, 10, 24, 2, 20, 1
+};
+
+// relative frequencies of dictionary word lengths 0..15
+static int defaultlengths[16] = {
+  0, 0, 2, 6, 10, 13, 14, 14, 13, 10, 7, 5, 3, 2, 1, 1
+};
+
+static int pickweighted(const int *w, int n) {
+  int sum = 0;
+  for (int i = 0; i < n; i++) sum += w[i];
+  if (sum <= 0)
+    throw error("No positive weight to pick from");
+  int r = rand() % sum;
+  for (int i = 0; i < n; i++) {
+    if (r < w[i]) return i;
+    r -= w[i];
+  }
+  return n - 1;
+}
+
+static void parselengths(const string &spec, int *w) {
+  for (int i = 0; i < MAXWORDLEN; i++)
+    w[i] = i < 16 ? defaultlengths[i] : 0;
+  if (spec.empty())
+    return;
+  for (int i = 0; i < MAXWORDLEN; i++) w[i] = 0;
+  const char *st = spec.c_str();
+  int total = 0;
+  while (*st) {
+    int len = strtol(st, (char**)&st, 10), weight = 1;
+    if (*st == ':') weight = strtol(st + 1, (char**)&st, 10);
+    if ((len < 1) || (len >= MAXWORDLEN) || (weight < 0))
+      throw error("Invalid length distribution");
+    w[len] = weight;
+    total += weight;
+    if (*st == ',') st++;
+    else if (*st) throw error("Invalid length distribution");
+  }
+  if (total == 0)
+    throw error("Invalid length distribution");
+}
+
+/**
+ * writes a dictionary of n distinct random words to a temporary file
+ * and returns its name. Letters follow english frequencies so that
+ * posting lists and trie fanout are skewed like in real word lists.
+ */
+
+static string makesynthetic(int n, const string &lengths) {
+  int lw[MAXWORDLEN];
+  parselengths(lengths, lw);
+
+  char fn[] = "/tmp/cwcdictXXXXXX";
+  int fd = mkstemp(fn);
+  if (fd == -1) throw error("Failed to create synthetic dictionary");
+  close(fd);
+  ofstream f(fn);
+
+  set<string> seen;
+  int tries = 0;
+  while ((int)seen.size() < n && tries++ < 4*n) {
+    int len = pickweighted(lw, MAXWORDLEN);
+    string w;
+    for (int i = 0; i < len; i++)
+      w += char('a' + pickweighted(letterfreq, 26));
+    if (seen.insert(w).second)
+      f << w << '\n';
+  }
+  return fn;
+}
+
+//////////////////////////////////////////////////////////////////////
+// workloads
+
+/**
+ * random: the original dodictbench workload. Each word length is
+ * filled in random position order, picking a random possible letter
+ * at each step as the solver would, until the pattern dies.
+ */
+
+static void random_workload(dict &ref, wordlist &wl, int nq,
+			    vector<dictquery> &qs) {
+  bool haslen[MAXWORDLEN];
+  for (int i = 0; i < MAXWORDLEN; i++) haslen[i] = false;
+  for (int i = 0; i < wl.numwords(); i++) {
+    int len = wordlen(wl[i]);
+    if (len < MAXWORDLEN) haslen[len] = true;
+  }
+
+  int o[MAXWORDLEN];
+  while ((int)qs.size() < nq) {
+    for (int len = 1; len < MAXWORDLEN && (int)qs.size() < nq; len++) {
+      if (!haslen[len]) continue;
+      dictquery q;
+      q.len = len;
+      for (int i = 0; i < len; i++) o[i] = i;
+      for (int i = 0; i < len; i++) {
+	q.pat[i] = symbol::empty;
+	int r = rand()%len;
+	int t = o[r]; o[r] = o[i]; o[i] = t;
+      }
+      q.pat[len] = symbol::outside;
+      for (int n = 0; n < len && (int)qs.size() < nq; n++) {
+	q.pos = o[n];
+	qs.push_back(q);
+	symbolset ss = ref.findpossible(q.pat, len, q.pos);
+	if (!ss) break;
+	q.pat[q.pos] = symbol::symbolbit(pickbit(ss));
+      }
+    }
+  }
+}
+
+/**
+ * known: patterns taken from random dictionary words with 0 to
+ * maxknown letters revealed, asking for one of the hidden positions.
+ */
+
+static void known_workload(wordlist &wl, int maxknown, int nq,
+			   vector<dictquery> &qs) {
+  int nwords = wl.numwords();
+  if (nwords == 0) return;
+  int o[MAXWORDLEN];
+  while ((int)qs.size() < nq) {
+    symbol *w = wl[rand() % nwords];
+    int len = wordlen(w);
+    if ((len < 2) || (len >= MAXWORDLEN)) continue;
+    int k = rand() % (maxknown + 1);
+    if (k >= len) k = len - 1;
+
+    dictquery q;
+    q.len = len;
+    for (int i = 0; i < len; i++) {
+      o[i] = i;
+      q.pat[i] = symbol::empty;
+    }
+    q.pat[len] = symbol::outside;
+    for (int i = 0; i < len; i++) {
+      int r = rand()%len;
+      int t = o[r]; o[r] = o[i]; o[i] = t;
+    }
+    for (int i = 0; i < k; i++)
+      q.pat[o[i]] = w[o[i]];
+    q.pos = o[k];
+    qs.push_back(q);
+  }
+}
+
+/**
+ * trace: replay a query log written by the solver with -Q.
+ */
+
+static void trace_workload(const string &fn, int nq, vector<dictquery> &qs) {
+  ifstream f(fn.c_str());
+  if (!f.is_open()) throw error("Failed to open query trace");
+  string pat;
+  int pos;
+  while ((int)qs.size() < nq && (f >> pat >> pos)) {
+    dictquery q;
+    q.len = pat.length();
+    if ((q.len == 0) || (q.len >= MAXWORDLEN) || (pos < 0) || (pos >= q.len))
+      throw error("Invalid query in trace: " + pat);
+    for (int i = 0; i < q.len; i++)
+      q.pat[i] = (pat[i] == '-') ? symbol::empty : symbol(pat[i]);
+    q.pat[q.len] = symbol::outside;
+    q.pos = pos;
+    qs.push_back(q);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+// the benchmark
+
+static string setstring(symbolset ss) {
+  string s;
+  for (int n = 0; n < MAXSYMBOLS; n++)
+    if (hassym(ss, n))
+      s += symbol::alphabet[n];
+  return s;
+}
+
+static string patstring(dictquery &q) {
+  string s;
+  for (int i = 0; i < q.len; i++)
+    s += (q.pat[i] == symbol::empty) ? '-' : char(q.pat[i]);
+  return s;
+}
+
+struct engineresult {
+  dictengine *e;
+  double buildms;
+  long mem;
+  double totalns;
+  vector<long long> lat;
+  int mismatches;
+  long long hw[NPERFCOUNTERS];
+};
+
+static long long percentile(vector<long long> &sorted, double p) {
+  if (sorted.empty()) return 0;
+  unsigned i = (unsigned)(p * sorted.size());
+  if (i >= sorted.size()) i = sorted.size() - 1;
+  return sorted[i];
+}
+
+void dodictbench() {
+  benchparams bp;
+  bp.parse(setup.benchopts);
+  srand(bp.seed);
+
+  string dictfile = setup.dictfile;
+  if (bp.words > 0)
+    dictfile = makesynthetic(bp.words, bp.lengths);
+
+  wordlist wl;
+  wl.load(dictfile);
+
+  int nengines = numdictengines();
+  vector<engineresult> res(nengines);
+  vector<dictquery> qs;
+  vector<symbolset> expected;
+
+  for (int e = 0; e < nengines; e++) {
+    engineresult &r = res[e];
+    r.e = &dictengines[e];
+    r.mismatches = 0;
+
+    dict *d = r.e->create();
+    long long t0 = hrtime();
+    d->load(dictfile);
+    r.buildms = (hrtime() - t0) / 1e6;
+    r.mem = d->memusage();
+
+    // the first engine serves as reference for workload and results
+    if (e == 0) {
+      if (bp.workload == "random")
+	random_workload(*d, wl, bp.queries, qs);
+      else if (bp.workload == "known")
+	known_workload(wl, bp.known, bp.queries, qs);
+      else if (bp.workload == "trace")
+	trace_workload(bp.trace, bp.queries, qs);
+      else
+	throw error("Unknown workload " + bp.workload);
+    }
+
+    int nq = qs.size();
+    r.lat.resize(nq);
+    r.totalns = 0;
+    perfcounters *pc = setup.perfcounters ? new perfcounters() : 0;
+    if (pc)
+      pc->start();
+    for (int i = 0; i < nq; i++) {
+      dictquery &q = qs[i];
+      long long t = hrtime();
+      symbolset ss = d->findpossible(q.pat, q.len, q.pos);
+      r.lat[i] = hrtime() - t;
+      r.totalns += r.lat[i];
+
+      if (e == 0)
+	expected.push_back(ss);
+      else if (ss != expected[i]) {
+	if (r.mismatches++ < 5)
+	  cerr << "mismatch: " << r.e->name << " " << patstring(q)
+	       << ' ' << q.pos << " {" << setstring(ss) << "} "
+	       << dictengines[0].name << " {" << setstring(expected[i])
+	       << '}' << endl;
+      }
+    }
+    if (pc) {
+      pc->read(r.hw);
+      if (!pc->available() && e == 0)
+	cerr << "hardware counters not available" << endl;
+      delete pc;
+    }
+    delete d;
+  }
+
+  if (bp.words > 0)
+    unlink(dictfile.c_str());
+
+  ofstream of;
+  if (!bp.out.empty()) {
+    of.open(bp.out.c_str());
+    if (!of.is_open()) throw error("Failed to open benchmark output");
+  }
+  ostream &os = bp.out.empty() ? cout : of;
+
+  os << "# dictionary=" << (bp.words > 0 ? string("synthetic") : dictfile)
+     << " words=" << wl.numwords() << " workload=" << bp.workload
+     << " queries=" << qs.size() << " seed=" << bp.seed << endl;
+  os << "engine\tbuild_ms\tmem_bytes\tqps\tp50_ns\tp90_ns\tp99_ns"
+     << "\tmax_ns\tmismatches";
+  for (int i = 0; setup.perfcounters && i < NPERFCOUNTERS; i++)
+    os << '\t' << perfcounters::names[i];
+  os << endl;
+  for (int e = 0; e < nengines; e++) {
+    engineresult &r = res[e];
+    vector<long long> sorted = r.lat;
+    sort(sorted.begin(), sorted.end());
+    double qps = r.totalns > 0 ? qs.size() * 1e9 / r.totalns : 0;
+    os << r.e->name << '\t' << r.buildms << '\t' << r.mem << '\t'
+       << long(qps) << '\t' << percentile(sorted, 0.5) << '\t'
+       << percentile(sorted, 0.9) << '\t' << percentile(sorted, 0.99)
+       << '\t' << percentile(sorted, 1.0) << '\t' << r.mismatches;
+    for (int i = 0; setup.perfcounters && i < NPERFCOUNTERS; i++)
+      os << '\t' << r.hw[i];
+    os << endl;
+  }
+}
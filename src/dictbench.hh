@@ -0,0 +1,81 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef DICTBENCH_HH
+#define DICTBENCH_HH
+
+#include <fstream>
+#include <vector>
+#include "symbol.hh"
+#include "dict.hh"
+
+/**
+ * Benchmark parameters are given as key=value pairs, one per -B
+ * option. Unknown keys are rejected so that typos do not silently
+ * produce a different workload.
+ */
+
+struct benchparams {
+  int words;          // synthetic dictionary size, 0 = use -d file
+  string lengths;     // length distribution, e.g. "3:1,4:2,5:4"
+  string workload;    // random, known or trace
+  int known;          // max known letters for the known workload
+  string trace;       // query log to replay (see -Q)
+  int queries;        // number of queries to run
+  int seed;
+  string out;         // result file, default stdout
+  int seeds;          // solver runs per grid
+  long nodelimit;     // give up a solver run after this many nodes
+  string baseline;    // earlier solver results to compare with
+  int tolerance;      // allowed slowdown in percent
+
+  benchparams();
+  void parse(const string &opts);
+};
+
+/**
+ * A single dictionary query as issued by cell::findpossible.
+ */
+
+struct dictquery {
+  symbol pat[MAXWORDLEN + 1];
+  int len, pos;
+};
+
+/**
+ * querylog_dict forwards to another dictionary and writes every
+ * query to a file, one per line as `pattern pos' with '-' for empty
+ * positions. The dictionary benchmark can replay such a log. The
+ * inner dictionary is owned by the querylog_dict.
+ */
+
+class querylog_dict : public dict {
+  dict &d;
+  ofstream f;
+public:
+  querylog_dict(dict *inner, const string &fn);
+  ~querylog_dict();
+  void load(const string &fn) { d.load(fn); }
+  symbolset findpossible(symbol *s, int len, int pos);
+  long memusage() { return d.memusage(); }
+};
+
+void dodictbench();
+
+#endif
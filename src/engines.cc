@@ -0,0 +1,96 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <stdlib.h>
+#include <strstream>
+#include <string>
+
+#include "engines.hh"
+#include "letterdict.hh"
+#include "bitreedict.hh"
+#include "hybriddict.hh"
+
+static dict *new_btree_dict() { return new btree_dict(); }
+static dict *new_letterdict() { return new letterdict(); }
+static dict *new_bitree_dict() { return new bitree_dict(); }
+static dict *new_hybrid_dict() { return new hybrid_dict(); }
+
+dictengine dictengines[] = {
+  { "btree", setup_s::btreedict, "binary tree index", new_btree_dict, false },
+  { "letter", setup_s::letterdict, "letter index", new_letterdict, false },
+  { "bitree", setup_s::bitreedict, "bidirectional tree index",
+    new_bitree_dict, false },
+  { "hybrid", setup_s::hybriddict, "hybrid index", new_hybrid_dict, true },
+  { 0, setup_s::btreedict, 0, 0, false }
+};
+
+int numdictengines() {
+  int n = 0;
+  while (dictengines[n].name) n++;
+  return n;
+}
+
+dictengine *finddictengine(const string &name) {
+  for (dictengine *e = dictengines; e->name; e++)
+    if (name == e->name)
+      return e;
+  return 0;
+}
+
+dictengine *finddictengine(setup_s::dict_t style) {
+  for (dictengine *e = dictengines; e->name; e++)
+    if (e->style == style)
+      return e;
+  return 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// dictparams
+
+dictparams dictopts;
+
+dictparams::dictparams()
+  : pairs(false), pairmin(250), pairmem(16L << 20),
+    packed(false), filter(0), liveinterval(10), kernels(true),
+    prune(false), threads(1) {
+}
+
+void dictparams::parse(const string &opts) {
+  istrstream is(opts.c_str());
+  string kv;
+  while (is >> kv) {
+    string::size_type eq = kv.find('=');
+    if (eq == string::npos)
+      throw error("Dictionary option must be key=value: " + kv);
+    string key = kv.substr(0, eq), val = kv.substr(eq + 1);
+    if (key == "pairs") pairs = atoi(val.c_str()) != 0;
+    else if (key == "pairmin") pairmin = atoi(val.c_str());
+    else if (key == "pairmem") pairmem = atol(val.c_str()) << 20;
+    else if (key == "packed") packed = atoi(val.c_str()) != 0;
+    else if (key == "filter") filter = atol(val.c_str()) << 10;
+    else if (key == "overlay") overlays.push_back(val);
+    else if (key == "block") blocklists.push_back(val);
+    else if (key == "updates") updates = val;
+    else if (key == "liveinterval") liveinterval = atoi(val.c_str());
+    else if (key == "kernels") kernels = atoi(val.c_str()) != 0;
+    else if (key == "prune") prune = atoi(val.c_str()) != 0;
+    else if (key == "threads") threads = atoi(val.c_str());
+    else throw error("Unknown dictionary option: " + key);
+  }
+}
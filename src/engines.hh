@@ -0,0 +1,75 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef ENGINES_HH
+#define ENGINES_HH
+
+#include <vector>
+#include "symbol.hh"
+#include "dict.hh"
+
+/**
+ * The engine table lists every dictionary index implementation. It
+ * resolves the -i option, and the benchmarks use it to run the same
+ * workload on all engines. New engines only need an entry here.
+ * Composite engines are built from the other engines and are not
+ * used as building blocks themselves.
+ */
+
+struct dictengine {
+  const char *name;
+  setup_s::dict_t style;
+  const char *description;
+  dict *(*create)();
+  bool composite;
+};
+
+extern dictengine dictengines[];
+int numdictengines();
+
+/**
+ * Tuning options for the dictionary engines, given as key=value
+ * pairs with -D. Engines read them from the global dictopts when
+ * they build their indexes.
+ */
+
+struct dictparams {
+  bool pairs;         // build the letter index position pair lists
+  int pairmin;        // both letter lists must be this long to pair them
+  long pairmem;       // pair list memory budget in bytes
+  bool packed;        // compress the letter index posting lists
+  long filter;        // pair filter size in bytes, 0 = no filter
+  vector<string> overlays;   // word lists stacked on the dictionary
+  vector<string> blocklists; // words removed from the dictionary
+  string updates;     // live word additions and removals to apply
+  int liveinterval;   // pause between update batches in msecs
+  bool kernels;       // query kernels specialized per word length
+  bool prune;         // index only the words the grid can use
+  int threads;        // index build threads
+
+  dictparams();
+  void parse(const string &opts);
+};
+
+extern dictparams dictopts;
+
+dictengine *finddictengine(const string &name);
+dictengine *finddictengine(setup_s::dict_t style);
+
+#endif
@@ -0,0 +1,176 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <math.h>
+#include <iostream.h>
+#include <vector>
+#include <list>
+
+#include "timer.hh"
+#include "symbol.hh"
+#include "grid.hh"
+#include "cwc.hh"
+#include "estimate.hh"
+
+//////////////////////////////////////////////////////////////////////
+// class spacecount
+
+vector<double> spacecount::invpow;
+double spacecount::logbase = 0;
+
+void spacecount::setbase(int base, int maxexp) {
+  if (base < 2) base = 2;
+  // already set up; concurrent searches share the table
+  if ((logbase == ::log10(double(base))) && (int(invpow.size()) > maxexp))
+    return;
+  logbase = ::log10(double(base));
+  invpow.resize(maxexp + 1);
+  invpow[0] = 1;
+  for (int i = 1; i <= maxexp; i++)
+    invpow[i] = invpow[i-1] / base;
+}
+
+void spacecount::add(double k, int exp) {
+  if (k == 0)
+    return;
+  if (exp > e) {
+    int shift = exp - e;
+    m = (shift < (int)invpow.size() ? m * invpow[shift] : 0) + k;
+    e = exp;
+  } else {
+    int shift = e - exp;
+    if (shift < (int)invpow.size())
+      m += k * invpow[shift];
+  }
+}
+
+double spacecount::log10() const {
+  if (m <= 0)
+    return -HUGE_VAL;
+  return ::log10(m) + e * logbase;
+}
+
+//////////////////////////////////////////////////////////////////////
+// class estimator
+
+// ln(exp(a) + exp(b))
+static double logadd(double a, double b) {
+  if (a < b) { double t = a; a = b; b = t; }
+  if (b == -HUGE_VAL) return a;
+  return a + log1p(exp(b - a));
+}
+
+estimator::estimator(grid &thegrid, walker &thewalker, dict &thedict)
+  : g(thegrid), w(thewalker), d(thedict) {
+  logtab.resize(MAXSYMBOLS + 1);
+  for (int k = 1; k <= MAXSYMBOLS; k++)
+    logtab[k] = log(double(k));
+}
+
+/**
+ * walks from the root to a dead end or a solution, choosing uniformly
+ * among the possible symbols, and returns ln of the probe's estimate.
+ * logsolutions is the estimate of the number of solutions.
+ */
+
+double estimator::probe(long &nodes, double &logsolutions) {
+  double logw = 0, logest = 0; // the root counts as one node
+  logsolutions = -HUGE_VAL;
+  while (1) {
+    nodes++;
+    int c = w.getcurrent();
+    symbolset ss = g(c).findpossible(d);
+    int k = numones(ss);
+    if (k == 0)
+      return logest;
+    logw += logtab[k];
+    logest = logadd(logest, logw);
+    g(c).setsymbol(symbol::symbolbit(pickbit(ss)));
+    if (!w.moresteps()) {
+      logsolutions = logw;
+      return logest;
+    }
+    w.forward();
+  }
+}
+
+void estimator::rewind() {
+  while (w.stepno() > 1)
+    w.backward();
+  g(w.getcurrent()).clear(false);
+}
+
+void estimator::run(int probes, ostream &os) {
+  w.forward();
+  double logsum = -HUGE_VAL, logsum2 = -HUGE_VAL;
+  double lo = HUGE_VAL, hi = -HUGE_VAL, logsolsum = -HUGE_VAL;
+  long nodes = 0;
+  int solutions = 0;
+
+  long long t0 = hrtime();
+  for (int i = 0; i < probes; i++) {
+    double logsol;
+    double x = probe(nodes, logsol);
+    rewind();
+    logsum = logadd(logsum, x);
+    logsum2 = logadd(logsum2, 2*x);
+    if (x < lo) lo = x;
+    if (x > hi) hi = x;
+    if (logsol != -HUGE_VAL) {
+      solutions++;
+      logsolsum = logadd(logsolsum, logsol);
+    }
+  }
+  double nsecpernode = double(hrtime() - t0) / nodes;
+
+  // mean and relative standard error of the mean, all in ln space
+  double logn = log(double(probes));
+  double logmean = logsum - logn;
+  double relvar = exp(logsum2 - logn - 2*logmean) - 1;
+  double rse = sqrt((relvar > 0 ? relvar : 0) / probes);
+  double loglo = rse < 0.5 ? logmean + log(1 - 1.96*rse) : lo;
+  if (loglo < lo) loglo = lo;
+  double loghi = logmean + log(1 + 1.96*rse);
+
+  double ln10 = log(10.0);
+  double logsecs = log(nsecpernode * 1e-9);
+  double logsolmean = logsolsum - logn;
+  double logfirst = logmean - logadd(0, logsolmean);
+  // a solution fills every open cell, one node each
+  if (logfirst < log(double(g.numopen())))
+    logfirst = log(double(g.numopen()));
+
+  os << "probes: " << probes << ", " << solutions << " reached a solution"
+     << endl;
+  os << "estimated tree size: 10^" << logmean / ln10 << " nodes (95% interval 10^"
+     << loglo / ln10 << " - 10^" << loghi / ln10 << ")" << endl;
+  os << "probe estimates ranged from 10^" << lo / ln10 << " to 10^"
+     << hi / ln10 << endl;
+  os << "estimated solutions: ";
+  if (solutions)
+    os << "10^" << logsolmean / ln10 << endl;
+  else
+    os << "none seen" << endl;
+  os << "time per node: " << nsecpernode / 1000 << " usecs" << endl;
+  os << "exhaustive search time: 10^" << (logmean + logsecs) / ln10
+     << " secs (95% interval 10^" << (loglo + logsecs) / ln10 << " - 10^"
+     << (loghi + logsecs) / ln10 << ")" << endl;
+  os << "expected time to first solution: 10^" << (logfirst + logsecs) / ln10
+     << " secs" << endl;
+}
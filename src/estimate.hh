@@ -0,0 +1,75 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef ESTIMATE_HH
+#define ESTIMATE_HH
+
+#include <vector>
+#include "grid.hh"
+#include "dict.hh"
+
+class walker;
+
+/**
+ * spacecount holds counts that outgrow a double, such as the number
+ * of fillings of a large grid, as m * base^e. Adding a term scales by
+ * a power of the base taken from a table, so the search does not call
+ * pow() per node.
+ */
+
+class spacecount {
+  double m;
+  int e;
+  static vector<double> invpow;  // base^-i
+  static double logbase;         // log10(base)
+public:
+  spacecount() : m(0), e(0) {}
+  static void setbase(int base, int maxexp);
+  void add(double k, int exp);
+  // adds o scaled by base^shift
+  void add(const spacecount &o, int shift = 0) { add(o.m, o.e + shift); }
+  double log10() const;          // -inf for zero
+};
+
+/**
+ * The estimator predicts the size of the search tree and the solve
+ * time by Knuth's method: random probes walk from the root to a leaf
+ * with the real walker, dictionary and pruning, and each probe
+ * estimates the tree size as 1 + d1 + d1*d2 + ..., where di is the
+ * number of possible symbols at step i. The mean over probes is an
+ * unbiased estimate of the plain backtracking tree; backjumping only
+ * makes the real search smaller. Weighting the probes that reach a
+ * solution the same way estimates the number of solutions, and the
+ * tree size divided by that gives the expected work until the first
+ * solution. Sums are kept in log space.
+ */
+
+class estimator {
+  grid &g;
+  walker &w;
+  dict &d;
+  vector<double> logtab;  // ln(k) for k possible symbols
+  double probe(long &nodes, double &logsolutions);
+  void rewind();
+public:
+  estimator(grid &thegrid, walker &thewalker, dict &thedict);
+  void run(int probes, ostream &os);
+};
+
+#endif
@@ -21,20 +21,81 @@
 #include <stdio.h>
 #include <strstream>
 
-#include <set>
+#include <pthread.h>
 #include "grid.hh"
+#include "pairfilter.hh"
 
 //////////////////////////////////////////////////////////////////////
 // wordblock
 
-wordblock::wordblock() {
-  cls_size = 0;
+void wordblock::getword(symbol *s) {
+  for (int i = 0; i < cls_size; i++)
+    s[i] = g->cellno(cls[i]).getsymbol();
 }
 
-void wordblock::getword(symbol *s) {
-  int i, len = cls.size();
-  for (i = 0; i < len; i++)
-    s[i] = cls[i]->getsymbol();
+//////////////////////////////////////////////////////////////////////
+// class emptymap
+
+void emptymap::init(vector<cell> &cells) {
+  int n = cells.size();
+  base = n ? &cells[0] : 0;
+  bits.assign((n + 63) / 64, 0);
+  summary.assign((bits.size() + 63) / 64, 0);
+  count = 0;
+  for (int i = 0; i < n; i++) {
+    cells[i].track(this);
+    if (cells[i].isempty())
+      update(&cells[i], true);
+  }
+}
+
+/**
+ * the -j part threads fill cells of the one grid at the same time, and
+ * cells of different parts share bitmap words, so the words and the
+ * count change atomically. A summary bit cleared for a word another
+ * thread has just set a bit in is set again.
+ */
+
+void emptymap::update(cell *c, bool empty) {
+  int i = c - base;
+  bitword bit = 1ULL << (i & 63), sbit = 1ULL << ((i >> 6) & 63);
+  bitword &w = bits[i >> 6], &s = summary[i >> 12];
+  if (empty) {
+    __sync_fetch_and_or(&w, bit);
+    __sync_fetch_and_or(&s, sbit);
+    __sync_fetch_and_add(&count, 1);
+  } else {
+    if ((__sync_fetch_and_and(&w, ~bit) & ~bit) == 0) {
+      __sync_fetch_and_and(&s, ~sbit);
+      if (__atomic_load_n(&w, __ATOMIC_SEQ_CST))
+	__sync_fetch_and_or(&s, sbit);
+    }
+    __sync_fetch_and_sub(&count, 1);
+  }
+}
+
+int emptymap::next(int from) {
+  if (from < 0) from = 0;
+  int wi = from >> 6;
+  if (wi >= int(bits.size()))
+    return -1;
+  bitword w = load(bits[wi]) & (~0ULL << (from & 63));
+  while (w == 0) {
+    // find the next non-empty bitmap word through the summary
+    wi++;
+    int si = wi >> 6;
+    if (si >= int(summary.size()))
+      return -1;
+    bitword s = load(summary[si]) & (~0ULL << (wi & 63));
+    while (s == 0) {
+      if (++si >= int(summary.size()))
+	return -1;
+      s = load(summary[si]);
+    }
+    wi = (si << 6) + __builtin_ctzll(s);
+    w = load(bits[wi]);     // may have been filled since, with -j
+  }
+  return (wi << 6) + __builtin_ctzll(w);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -43,13 +104,8 @@ void wordblock::getword(symbol *s) {
 cell cell::outside_cell;
 
 cell::cell(symbol s) : 
-  wbl_size(0), attempts(0), symb(s), preferred(symbol::none), locked(false) {
-}
-
-void cell::addword(wordblock *w, int pos) {
-  struct wordref wr = {pos, w};
-  wbl.push_back(wr);
-  wbl_size++;
+  wbl(0), wbl_size(0), attempts(0), symb(s), preferred(symbol::none),
+  locked(false), empties(0) {
 }
 
 void cell::setsymbol(const symbol &s) {
@@ -57,11 +113,11 @@ void cell::setsymbol(const symbol &s) {
     throw error("Attempt to set symbol in locked cell");
   if (s != symbol::empty && s != symbol::outside)
     attempts++;
-  symb = s;
+  setsymb(s);
 }
 
 void cell::remove() {
-  symb = symbol::outside;
+  setsymb(symbol::outside);
 }
 
 void cell::clear(bool setpreferred) {
@@ -69,7 +125,7 @@ void cell::clear(bool setpreferred) {
     preferred = symb;
   else
     preferred = symbol::none;
-  symb = symbol::empty;
+  setsymb(symbol::empty);
 }
 
 ostream &operator << (ostream &os, cell &c) {
@@ -104,13 +160,60 @@ grid::grid(int width, int height)
   buildwords();
 }
 
+grid::~grid() {
+  deletewords();
+}
+
+void grid::deletewords() {
+  for (int i = 0; i < cls_size; i++)
+    cls[i].clearwords();
+  wbl.clear();
+  slotcells.clear();
+  slotstart.clear();
+  cellrefs.clear();
+  adjstart.clear();
+  adj.clear();
+}
+
 void grid::init_grid(int w, int h) {
   this->w = w;
   this->h = h;
-  cls.clear();
-  for (int i = 0; i < w*h; i++)
-    cls.push_back(cell());
+  deletewords();
+  cls.assign(w*h, cell());
   cls_size = cls.size();
+  nopen = cls_size;
+  empties.init(cls);
+}
+
+/**
+ * builds the slots and the cell references from slotcells and
+ * slotstart, counting the references of every cell first so the
+ * pool is filled in place.
+ */
+
+void grid::linkwords() {
+  int nslots = slotstart.size() - 1;
+  wbl.assign(nslots, wordblock());
+  vector<int> start(cls_size + 1, 0);
+  for (unsigned i = 0; i < slotcells.size(); i++)
+    start[slotcells[i] + 1]++;
+  for (int c = 0; c < cls_size; c++)
+    start[c+1] += start[c];
+  cellrefs.resize(slotcells.size());
+  vector<int> fill(start.begin(), start.end() - 1);
+  for (int s = 0; s < nslots; s++) {
+    int *cells = &slotcells[0] + slotstart[s];
+    int len = slotstart[s+1] - slotstart[s];
+    wbl[s].setcells(*this, cells, len);
+    for (int p = 0; p < len; p++) {
+      wordref &r = cellrefs[fill[cells[p]]++];
+      r.pos = p;
+      r.wbl = &wbl[s];
+    }
+  }
+  for (int c = 0; c < cls_size; c++)
+    cls[c].setwords(cellrefs.empty() ? 0 : &cellrefs[0] + start[c],
+		    start[c+1] - start[c]);
 }
 
 /**
@@ -147,6 +250,24 @@ symbolset cell::findpossible(dict &d) {
   
   symbolset ss = ~0;
 
+  if (activefilter) {
+    // cheap upper bound from the letter pair filter
+    symbolset cand = activefilter->letters();
+    for (int i = 0; i < nwords && cand; i++) {
+      wordblock &wb = getwordblock(i);
+      int len = wb.length();
+      symbol word[len+1]; word[len] = symbol::outside;
+      wb.getword(word);
+      cand = activefilter->bound(word, len, getpos(i), cand);
+    }
+    // -j parts probe the one filter from several threads
+    __sync_fetch_and_add(&activefilter->probes, 1);
+    if (cand == 0) {
+      __sync_fetch_and_add(&activefilter->rejects, 1);
+      return 0;
+    }
+  }
+
   for (int i = 0; i < nwords; i++) {
 
     int pos = getpos(i);
@@ -194,8 +315,8 @@ void grid::load_template(const string &filename) {
 	cellat(x, y).clear();
       else if (ch == ' ' )
 	cellat(x, y).remove();
-      else if (isalpha(ch))
-	cellat(x, y).setsymbol(tolower(ch));
+      else if (wordchar(ch))
+	cellat(x, y).setsymbol(symbol::await(tolower(ch)));
       else
 	throw error("Invalid character in input file");
     }
@@ -204,38 +325,62 @@ void grid::load_template(const string &filename) {
   lock();
 }
 
+/**
+ * reads the cell numbers of one line of a general grid into cells, or
+ * only counts them if cells is 0. Returns the number of cells.
+ */
+
+static int parseslot(const string &ln, int *cells, int &maxcell) {
+  const char *st = ln.c_str();
+  int n = 0;
+  while (*st) {
+    while (*st && !isdigit(*st)) st++;
+    if (!*st) break;
+    int a = 0;
+    while (isdigit(*st))
+      a = a*10 + (*st++ - '0');
+    if (a > maxcell) maxcell = a;
+    if (cells) cells[n] = a;
+    n++;
+  }
+  return n;
+}
+
 void grid::load(const string &fn) {
-  cls.clear();
-  wbl.clear();
+  deletewords();
   w = h = 0;
 
   ifstream f(fn.c_str());
   if (!f.is_open()) throw error("Failed to open file");
   string ln;
 
-  while (!f.eof()) {
-    getline(f, ln);
-    const char *st = ln.c_str();
-    
-    wordblock *wb = new wordblock();
-    int pos = 0;
-    while (*st != '\0') {
-      while (*st&&(!isdigit(*st))) st++;
-      if (*st == '\0') break;
-      int a = atoi(st);
-      while (cls.size() <= unsigned(a))
-	cls.push_back(cell(symbol::outside));
-      cls_size = cls.size();
-      cls[a].setsymbol(symbol::empty);
-      wb->addcell(a, *this);
-      cls[a].addword(wb, pos); pos++;
-      while (*st && (isdigit(*st))) st++;
-    }
-    if (wb->length())
-      wbl.push_back(wb);
-    else
-      delete wb;
+  // count slots, references and cells
+  long nrefs = 0;
+  int nslots = 0, maxcell = -1;
+  while (getline(f, ln)) {
+    int n = parseslot(ln, 0, maxcell);
+    if (n) { nslots++; nrefs += n; }
   }
+
+  slotcells.resize(nrefs);
+  slotstart.resize(nslots + 1);
+  f.clear();
+  f.seekg(0);
+  int s = 0;
+  long used = 0;
+  slotstart[0] = 0;
+  while (s < nslots && getline(f, ln)) {
+    int n = parseslot(ln, &slotcells[0] + used, maxcell);
+    if (n) { used += n; slotstart[++s] = used; }
+  }
+  if (s < nslots) throw error("Grid file changed while loading");
+
+  cls.assign(maxcell + 1, cell(symbol::outside));
+  cls_size = cls.size();
+  for (long i = 0; i < nrefs; i++)
+    cls[slotcells[i]].setsymbol(symbol::empty);
+  empties.init(cls);
+  linkwords();
   lock();
 }
 
@@ -244,46 +389,34 @@ void grid::load(const string &fn) {
  */
 
 void grid::buildwords() {
-  wbl.clear();
-  for (int n = 0; n < numcells(); n++)
-    cls[n].clearwords();
-
+  deletewords();
+  slotstart.push_back(0);
   for (int y = 0; y < h; y++) {
     for (int x = 0; x < w; x++) {
-      int cno = cellnofromxy(x, y);
-      wordblock *w = 0;
-      int pos = 0;
-      while (cellat(x, y).isinside()) {
-	if (w==0) { w = new wordblock(); wbl.push_back(w); }
-	w->addcell(cno, *this);
-	cellno(cno).addword(w, pos);
-	pos++;
-	x++;
-	cno = cellnofromxy(x, y);
-      }
+      if (!cellat(x, y).isinside()) continue;
+      while (cellat(x, y).isinside())
+	slotcells.push_back(cellnofromxy(x++, y));
+      slotstart.push_back(slotcells.size());
     }
   }
   for (int x = 0; x < w; x++) {
     for (int y = 0; y < h; y++) {
-      wordblock *w = 0;
-      int pos = 0;
-      while (cellat(x, y).isinside()) {
-	if (w == 0) { w = new wordblock(); wbl.push_back(w); }
-	w->addcell(cellnofromxy(x, y), *this);
-	cellat(x, y).addword(w, pos);
-	pos++; y++;
-      }
+      if (!cellat(x, y).isinside()) continue;
+      while (cellat(x, y).isinside())
+	slotcells.push_back(cellnofromxy(x, y++));
+      slotstart.push_back(slotcells.size());
     }
   }
+  linkwords();
 }
 
 void grid::dump_ggrid(ostream &os) {
   bool first = true;
-  for (vector<wordblock*>::iterator i = wbl.begin(); i != wbl.end(); i++) {
-    int wlen = (*i)->length();
+  for (vector<wordblock>::iterator i = wbl.begin(); i != wbl.end(); i++) {
+    int wlen = i->length();
     for (int p = 0; p < wlen; p++) {
       if (!first) cout << ' ';
-      os << (*i)->getcellno(p);
+      os << i->getcellno(p);
       first = false;
     }
     os << endl; first = true;
@@ -327,17 +460,17 @@ void grid::dump_simple(ostream &os) {
 void grid::dump(ostream &os, setup_s::output_format_t fmt) {
   if (w == 0) {
     for (int i = 0; unsigned(i) < wbl.size(); i++) {
-      int len = wbl[i]->length();
+      int len = wbl[i].length();
       symbol *s = new symbol[len + 1];
       s[len] = symbol::outside;
-      wbl[i]->getword(s);
+      wbl[i].getword(s);
       cout << s << ' ';
       delete s;
 
       cout << '(';
       for (int p = 0; p < len; p++) {
 	if (p) cout << ',';
-	cout << wbl[i]->getcellno(p);
+	cout << wbl[i].getcellno(p);
       }
       cout << ')' << endl;
     }
@@ -352,91 +485,178 @@ void grid::dump(ostream &os, setup_s::output_format_t fmt) {
   }
 }
 
+// the share of cells in two or more slots longer than one letter
 float grid::interlockdegree() {
   int interlocked = 0, total = 0;
-  for (int y=0; y<h; y++) {
-    for (int x=0;x<w;x++) {
-      if (cellat(x, y).isinside()) {
-	bool vertuse = cellat(x, y-1).isinside() || cellat(x, y+1).isinside();
-	bool horizuse = cellat(x-1, y).isinside() || cellat(x+1, y).isinside();
-	if (vertuse && horizuse)
-	  interlocked++;
-	total++;
-      }
-    }
+  for (int i = 0; i < cls_size; i++) {
+    if (cls[i].isoutside()) continue;
+    int used = 0;
+    for (int w = 0; w < cls[i].numwords(); w++)
+      if (cls[i].getwordblock(w).length() > 1)
+	used++;
+    if (used >= 2)
+      interlocked++;
+    total++;
   }
   return float(interlocked) / float(total);
 }
 
 float grid::attemptaverage() {
   int sum = 0, n = 0;
-  for (int y=0; y<h; y++) {
-    for (int x=0; x<w; x++) {
-      if (cellat(x, y).isinside()) {
-	sum += cellat(x, y).getattempts();
-	n++;
-      }
+  for (int i = 0; i < cls_size; i++) {
+    if (cls[i].isinside()) {
+      sum += cls[i].getattempts();
+      n++;
     }
   }
   return sum / float(n);
 }
 
-double grid::depencydegree(int level) {
-  int n = numcells(), ncell = 0;
-  int d = 0;
-  for (int i = 0; i < n; i++) {
-    if (cellno(i).isinside()) {
-      d += celldepencies(i, level);
-      ncell++;
+/**
+ * builds the cell adjacency: for every cell the other cells it shares
+ * a slot with, each once, in one array (CSR form like cellrefs).
+ */
+
+void grid::buildadjacency() {
+  adjstart.assign(1, 0);
+  adj.clear();
+  vector<int> mark(cls_size, -1);
+  for (int c = 0; c < cls_size; c++) {
+    mark[c] = c;
+    for (int w = 0; w < cls[c].numwords(); w++) {
+      wordblock &wb = cls[c].getwordblock(w);
+      for (int p = 0; p < wb.length(); p++) {
+	int n = wb.getcellno(p);
+	if (mark[n] == c) continue;
+	mark[n] = c;
+	adj.push_back(n);
+      }
     }
+    adjstart.push_back(adj.size());
   }
-  return double(d) / double(ncell);
-}
-
-int grid::celldepencies(int cno, int level) {
-  set<int> cnums;
-  cnums.insert(cno);
-
-  while (level--) {
-    set<int> newnums;
-    for (set<int>::iterator i = cnums.begin(); i != cnums.end(); i++) {
-      int clno = *i;
-      int words = cellno(clno).numwords();
-      for (int w = 0; w < words; w++) {
-	wordblock &wb = cellno(clno).getwordblock(w);
-	int wlen = wb.length();
-	for (int j = 0; j < wlen; j++)
-	  newnums.insert(wb.getcellno(j));
+}
+
+/**
+ * counts the cells within a number of slot steps of a cell by a level
+ * at a time breadth first search over the adjacency. Cells are marked
+ * visited with the number of the current search, so the marks need no
+ * clearing between cells.
+ */
+
+struct depscan {
+  grid *g;
+  int level;
+  const vector<int> *cells;
+  int from, to;
+  double sum;
+  vector<unsigned> mark;
+  vector<int> frontier, next;
+  unsigned epoch;
+
+  int reach(int c) {
+    epoch++;
+    mark[c] = epoch;
+    frontier.assign(1, c);
+    int n = 1;
+    for (int l = 0; l < level && !frontier.empty(); l++) {
+      next.clear();
+      for (unsigned i = 0; i < frontier.size(); i++) {
+	int f = frontier[i];
+	for (int a = g->adjstart[f]; a < g->adjstart[f+1]; a++) {
+	  int nb = g->adj[a];
+	  if (mark[nb] == epoch) continue;
+	  mark[nb] = epoch;
+	  next.push_back(nb);
+	}
       }
+      n += next.size();
+      frontier.swap(next);
     }
-    for (set<int>::iterator i = newnums.begin(); i != newnums.end(); i++)
-      cnums.insert(*i);
+    return n;
+  }
+
+  void run() {
+    mark.assign(g->numcells(), 0);
+    epoch = 0;
+    sum = 0;
+    for (int i = from; i < to; i++)
+      sum += reach((*cells)[i]);
+  }
+
+  static void *thread(void *arg) {
+    ((depscan*)arg)->run();
+    return 0;
+  }
+};
+
+/**
+ * the average number of cells within level slot steps of a cell. With
+ * sample > 0 only that many cells, evenly spread over the grid, are
+ * counted; the cells are divided between threads.
+ */
+
+double grid::depencydegree(int level, int threads, int sample) {
+  if (adjstart.empty())
+    buildadjacency();
+  vector<int> cells;
+  for (int i = 0; i < cls_size; i++)
+    if (cls[i].isinside())
+      cells.push_back(i);
+  if (cells.empty())
+    return 0;
+  if (sample > 0 && unsigned(sample) < cells.size()) {
+    vector<int> picked(sample);
+    for (int i = 0; i < sample; i++)
+      picked[i] = cells[long(i) * cells.size() / sample];
+    cells.swap(picked);
   }
-  return cnums.size();
+
+  int n = cells.size();
+  if (threads < 1) threads = 1;
+  if (threads > n) threads = n;
+  vector<depscan> scans(threads);
+  for (int t = 0; t < threads; t++) {
+    scans[t].g = this;
+    scans[t].level = level;
+    scans[t].cells = &cells;
+    scans[t].from = long(t) * n / threads;
+    scans[t].to = long(t+1) * n / threads;
+  }
+  vector<pthread_t> tids(threads);
+  int started = 1;
+  while (started < threads &&
+	 pthread_create(&tids[started], 0, depscan::thread, &scans[started]) == 0)
+    started++;
+  if (started < threads) {
+    // the running threads use scans and cells, so they finish first
+    for (int t = 1; t < started; t++)
+      pthread_join(tids[t], 0);
+    throw error("Failed to start analysis thread");
+  }
+  scans[0].run();
+  double d = scans[0].sum;
+  for (int t = 1; t < threads; t++) {
+    pthread_join(tids[t], 0);
+    d += scans[t].sum;
+  }
+  return d / n;
+}
+
+long grid::memusage() {
+  return cls.capacity() * sizeof(cell) + wbl.capacity() * sizeof(wordblock)
+    + slotcells.capacity() * sizeof(int) + slotstart.capacity() * sizeof(int)
+    + cellrefs.capacity() * sizeof(wordref) + empties.memusage()
+    + (adjstart.capacity() + adj.capacity()) * sizeof(int);
 }
 
 void grid::lock() {
   int n = numcells();
-  for (int i = 0; i < n; i++)
+  nopen = 0;
+  for (int i = 0; i < n; i++) {
     if (!cellno(i).isempty())
       cellno(i).lock();
-}
-
-int grid::getempty() { 
-  int n = 0;
-  int ncells = numcells();
-  for (int i = 0 ; i< ncells; i++)
-    if (cellno(i).isempty())
-      n++;
-  return n;
-}
-
-int grid::numopen() {
-  int n=0;
-  int ncells = numcells();
-  for (int i = 0; i < ncells; i++)
-    if (!cls[i].islocked())
-      n++;
-  return n;
+    else
+      nopen++;
+  }
 }
 
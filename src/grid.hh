@@ -33,12 +33,44 @@ struct wordref {
   wordblock *wbl;
 };
 
+/**
+ * The empty cells of a grid as a bitmap with a count, kept up to date
+ * by the cells as they change. A summary bit per bitmap word lets
+ * next() skip filled stretches 4096 cells at a time, so walkers do
+ * not scan the grid for the next empty cell. Updates are atomic, as
+ * the -j part threads fill cells of the same grid.
+ */
+
+class emptymap {
+  typedef unsigned long long bitword;
+  vector<bitword> bits, summary;
+  cell *base;
+  int count;
+  static bitword load(bitword &w) { return __atomic_load_n(&w, __ATOMIC_RELAXED); }
+public:
+  emptymap() : base(0), count(0) {}
+  void init(vector<cell> &cells);
+  void update(cell *c, bool empty);
+  int size() { return __atomic_load_n(&count, __ATOMIC_RELAXED); }
+  int next(int from);   // first empty cell from on, -1 if none
+  long memusage() {
+    return (bits.capacity() + summary.capacity()) * sizeof(bitword);
+  }
+};
+
 class cell {
-  vector<wordref> wbl; int wbl_size;
+  wordref *wbl; int wbl_size;   // in the grid's reference pool
   int attempts;
   symbol symb;
   symbol preferred;
   bool locked;
+  emptymap *empties;
+  void setsymb(const symbol &s) {
+    bool was = isempty();
+    symb = s;
+    if (empties && was != isempty())
+      empties->update(this, !was);
+  }
 public:
   static cell outside_cell;
 
@@ -46,11 +78,12 @@ public:
   void setsymbol(const symbol &s);
 
   // structural methods
-  void addword(wordblock *w, int pos);
+  void setwords(wordref *refs, int n) { wbl = refs; wbl_size = n; }
+  void track(emptymap *m) { empties = m; }
   int numwords() { return wbl_size; }
   wordblock &getwordblock(int wordno) { return *wbl[wordno].wbl; }
   int getpos(int wordno) { return wbl[wordno].pos; }
-  void clearwords() { wbl.clear(); }
+  void clearwords() { wbl = 0; wbl_size = 0; }
 
   symbol getsymbol() { return symb; }
   symbol getpreferred() { return preferred; }
@@ -94,16 +127,37 @@ public:
   bool operator==(const coord &c) const { return ((x==c.x)&&(y==c.y)); }
 };
 
+/**
+ * Cells, slots and the references between them are held in flat
+ * pools: the cell numbers of all slots in one array, the slot
+ * references of all cells in another, each cell and slot pointing to
+ * its run. The general grid loader reads the file twice, first to
+ * count and then to fill, so every pool is allocated once at its
+ * exact size. The empty and open cell counts are maintained rather
+ * than counted.
+ */
+
 class grid {
 protected:
   vector<cell> cls; int cls_size;
-  vector<wordblock*> wbl;
+  vector<wordblock> wbl;
+  vector<int> slotcells;          // cell numbers, slot after slot
+  vector<int> slotstart;          // slot i is slotstart[i]..[i+1]
+  vector<wordref> cellrefs;       // slot references, cell after cell
+  vector<int> adjstart, adj;      // cells sharing a slot, cell after cell
+  emptymap empties;
+  int nopen;
   void init_grid(int w, int h);
+  void deletewords();
+  void linkwords();
+  void buildadjacency();
+  friend struct depscan;
 
 public:
   bool verbose;
   int w, h;
   grid(int width = 4, int height = 4);
+  ~grid();
 
   inline cell &cellno(int n) {
     if ((n < 0)||(n >= cls_size))
@@ -140,46 +194,36 @@ public:
 
   void lock();
 
-  int getempty();
+  int getempty() { return empties.size(); }
+  int nextempty(int from) { return empties.next(from); }
 
   // statistics
 
   float interlockdegree();
   float density();
   float attemptaverage();
-  int numopen();
+  int numopen() { return nopen; }
   int numcells() { return cls.size(); }
-  double depencydegree(int level);
-  int celldepencies(int cellno, int level);
-};
-
-
-struct cellref {
-  int cellno;
-  grid *g;
-  cellref(int no, grid &gr) : cellno(no), g(&gr) {}
-  cell *operator ->() { return &g->cellno(cellno); }
-  cell *ptr() { return &g->cellno(cellno); }
+  long memusage();
+  double depencydegree(int level, int threads = 1, int sample = -1);
 };
 
 
 class wordblock {
-  vector<cellref> cls; int cls_size;
+  int *cls; int cls_size;         // in the grid's cell number pool
+  grid *g;
 public:
-  wordblock();
-  void addcell(int n, grid &gr) {
-    cls.push_back(cellref(n, gr));
-    cls_size++;
-  }
+  wordblock() : cls(0), cls_size(0), g(0) {}
+  void setcells(grid &gr, int *cells, int n) { g = &gr; cls = cells; cls_size = n; }
   int length() { return cls_size; }
   void getword(symbol *);
   int getcellno(int pos) { 
     if ((pos < 0)||(pos >= cls_size)) throw error("Bug");
-    return cls[pos].cellno; 
+    return cls[pos]; 
   }
   cell &getcell(int pos) { 
     if ((pos < 0)||(pos >= cls_size)) return cell::outside_cell;
-    return *cls[pos].ptr(); 
+    return g->cellno(cls[pos]); 
   }
 };
 
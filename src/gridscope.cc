@@ -0,0 +1,101 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <algo.h>
+
+#include "grid.hh"
+#include "gridscope.hh"
+
+// more patterns than this for one length are not worth matching
+#define MAXPATTERNS 256
+
+gridscope *activescope = 0;
+
+//////////////////////////////////////////////////////////////////////
+// class gridscope
+
+gridscope::gridscope(grid &g) {
+  for (int len = 0; len < MAXWORDLEN; len++)
+    lengths[len] = open[len] = false;
+  symbol s[MAXWORDLEN + 1];
+  for (int c = 0; c < g.numcells(); c++) {
+    cell &cl = g.cellno(c);
+    for (int w = 0; w < cl.numwords(); w++) {
+      if (cl.getpos(w) != 0) continue;     // each slot once
+      wordblock &wb = cl.getwordblock(w);
+      int len = wb.length();
+      if (len >= MAXWORDLEN) continue;
+      lengths[len] = true;
+      if (open[len]) continue;
+      wb.getword(s);
+      string p(len, '\0');
+      bool known = false;
+      for (int i = 0; i < len; i++)
+	if (s[i] != symbol::empty) {
+	  p[i] = char(s[i]);
+	  known = true;
+	}
+      if (known)
+	patterns[len].push_back(p);
+      else
+	open[len] = true;
+    }
+  }
+  for (int len = 0; len < MAXWORDLEN; len++) {
+    vector<string> &ps = patterns[len];
+    sort(ps.begin(), ps.end());
+    ps.erase(unique(ps.begin(), ps.end()), ps.end());
+    if (open[len] || ps.size() > MAXPATTERNS) {
+      open[len] = true;
+      ps.clear();
+    }
+  }
+}
+
+// true if a slot of the grid can hold word
+bool gridscope::allows(const string &word) {
+  unsigned len = word.length();
+  if (len >= MAXWORDLEN || !lengths[len])
+    return false;
+  if (open[len])
+    return true;
+  vector<string> &ps = patterns[len];
+  for (unsigned p = 0; p < ps.size(); p++) {
+    unsigned i = 0;
+    while (i < len && (!ps[p][i] || ps[p][i] == tolower(word[i])))
+      i++;
+    if (i == len)
+      return true;
+  }
+  return false;
+}
+
+int gridscope::numlengths() {
+  int n = 0;
+  for (int len = 0; len < MAXWORDLEN; len++)
+    if (lengths[len]) n++;
+  return n;
+}
+
+int gridscope::numpatterns() {
+  int n = 0;
+  for (int len = 0; len < MAXWORDLEN; len++)
+    n += patterns[len].size();
+  return n;
+}
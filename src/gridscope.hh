@@ -0,0 +1,52 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef GRIDSCOPE_HH
+#define GRIDSCOPE_HH
+
+#include <vector>
+#include "symbol.hh"
+
+class grid;
+
+/**
+ * gridscope is the part of the dictionary a grid can use: the words
+ * of the slot lengths that occur, and for lengths where every slot has
+ * locked letters (from a template), only the words that match one of
+ * those slots. With -D prune=1 the grid is loaded before the
+ * dictionary and the word list loaders skip the words outside the
+ * active scope, so the index is built for this grid only. Overlay and
+ * block files are read through the same loaders; words added by live
+ * updates are not pruned.
+ */
+
+class gridscope {
+  bool lengths[MAXWORDLEN];        // a slot has this length
+  bool open[MAXWORDLEN];           // a slot of this length has no letters
+  vector<string> patterns[MAXWORDLEN]; // locked letters, '\0' where empty
+public:
+  gridscope(grid &g);
+  bool allows(const string &word);
+  int numlengths();
+  int numpatterns();
+};
+
+extern gridscope *activescope;
+
+#endif
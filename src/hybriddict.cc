@@ -0,0 +1,189 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <stdlib.h>
+#include <iostream.h>
+#include <vector>
+
+#include "timer.hh"
+#include "engines.hh"
+#include "hybriddict.hh"
+
+hybrid_dict::hybrid_dict() {
+  for (int i = 0; i < MAXWORDLEN; i++) lencount[i] = 0;
+  for (int i = 0; i < HYBRID_CLASSES; i++) route[i] = 0;
+}
+
+hybrid_dict::~hybrid_dict() {
+  for (unsigned i = 0; i < engines.size(); i++)
+    delete engines[i];
+}
+
+#define SYMBCOUNT(len, pos, s) symbcount[((len)*MAXWORDLEN + (pos))*MAXSYMBOLS + (s)]
+
+/**
+ * classifies a pattern by known prefix (0-3+), known suffix (0-2+),
+ * fixed letters (0-3+) and selectivity of the rarest fixed letter,
+ * in four steps of 1/8.
+ */
+
+int hybrid_dict::shapeclass(symbol *s, int len) {
+  int prefix = 0, suffix = 0, fixed = 0, rarest = lencount[len];
+  while ((prefix < len) && (s[prefix] != symbol::empty)) prefix++;
+  while ((suffix < len) && (s[len-1-suffix] != symbol::empty)) suffix++;
+  for (int i = 0; i < len; i++) {
+    if (s[i] == symbol::empty) continue;
+    fixed++;
+    int n = SYMBCOUNT(len, i, s[i].symbvalue());
+    if (n < rarest) rarest = n;
+  }
+  int sel = 0;
+  for (long n = rarest * 8L; (n < lencount[len]) && (sel < 3); n *= 8)
+    sel++;
+  if (prefix > 3) prefix = 3;
+  if (suffix > 2) suffix = 2;
+  if (fixed > 3) fixed = 3;
+  return ((prefix*3 + suffix)*4 + fixed)*4 + sel;
+}
+
+/**
+ * times every engine on sample queries taken from dictionary words,
+ * revealing random letters, prefixes or suffixes, and routes each
+ * class to the engine with the lowest total time. Classes without
+ * samples use the engine that was fastest overall.
+ */
+
+void hybrid_dict::calibrate(int nsamples) {
+  int nengines = engines.size();
+  vector<double> cost(HYBRID_CLASSES * nengines, 0), total(nengines, 0);
+  int nwords = wl.numwords();
+  symbol pat[MAXWORDLEN + 1];
+  unsigned seed = 1;    // leave the solver's random sequence alone
+
+  for (int q = 0; q < nsamples && nwords; q++) {
+    symbol *w = wl[rand_r(&seed) % nwords];
+    int len = wordlen(w);
+    if ((len < 2) || (len >= MAXWORDLEN)) continue;
+    int k = rand_r(&seed) % len, style = rand_r(&seed) % 4, pos;
+    for (int i = 0; i < len; i++) pat[i] = symbol::empty;
+    pat[len] = symbol::outside;
+    if (style == 0) {           // known prefix
+      for (int i = 0; i < k; i++) pat[i] = w[i];
+      pos = k;
+    } else if (style == 1) {    // known suffix
+      for (int i = 0; i < k; i++) pat[len-1-i] = w[len-1-i];
+      pos = len-1-k;
+    } else {                    // scattered letters
+      for (int j = 0; j < k; j++) {
+	int i = rand_r(&seed) % len;
+	pat[i] = w[i];
+      }
+      pos = rand_r(&seed) % len;
+      pat[pos] = symbol::empty;
+    }
+    int cl = shapeclass(pat, len);
+    for (int e = 0; e < nengines; e++) {
+      long long t0 = hrtime();
+      engines[e]->findpossible(pat, len, pos);
+      double t = hrtime() - t0;
+      cost[cl*nengines + e] += t;
+      total[e] += t;
+    }
+  }
+
+  int best = 0;
+  for (int e = 1; e < nengines; e++)
+    if (total[e] < total[best]) best = e;
+  for (int cl = 0; cl < HYBRID_CLASSES; cl++) {
+    int r = best;
+    for (int e = 0; e < nengines; e++)
+      if (cost[cl*nengines + e] < cost[cl*nengines + r]) r = e;
+    if (cost[cl*nengines + r] == 0) r = best;
+    route[cl] = r;
+  }
+}
+
+void hybrid_dict::reportroutes() {
+  int nengines = engines.size();
+  vector<int> routed(nengines, 0);
+  for (int cl = 0; cl < HYBRID_CLASSES; cl++)
+    routed[route[cl]]++;
+  cout << "hybrid routing:";
+  for (int e = 0; e < nengines; e++)
+    cout << ' ' << names[e] << '=' << routed[e];
+  cout << " of " << HYBRID_CLASSES << " pattern classes" << endl;
+}
+
+void hybrid_dict::load(const string &fn) {
+  for (dictengine *e = dictengines; e->name; e++) {
+    if (e->composite) continue;
+    dict *d = e->create();
+    d->load(fn);
+    engines.push_back(d);
+    names.push_back(e->name);
+  }
+  wl.load(fn);
+  prepare();
+  reportroutes();
+}
+
+void hybrid_dict::loadwords(const vector<string> &words) {
+  for (dictengine *e = dictengines; e->name; e++) {
+    if (e->composite) continue;
+    dict *d = e->create();
+    d->loadwords(words);
+    engines.push_back(d);
+    names.push_back(e->name);
+  }
+  for (unsigned i = 0; i < words.size(); i++)
+    wl.addword(words[i]);
+  prepare();
+}
+
+/**
+ * counts letters per length and position for the selectivity of
+ * patterns, then calibrates the routing table.
+ */
+
+void hybrid_dict::prepare() {
+  if (engines.empty())
+    throw error("No engines for hybrid dictionary");
+  symbcount.assign(MAXWORDLEN * MAXWORDLEN * MAXSYMBOLS, 0);
+  for (int i = 0; i < wl.numwords(); i++) {
+    symbol *w = wl[i];
+    int len = wordlen(w);
+    if (len >= MAXWORDLEN) continue;
+    lencount[len]++;
+    for (int p = 0; p < len; p++)
+      SYMBCOUNT(len, p, w[p].symbvalue())++;
+  }
+  calibrate(3000);
+}
+
+long hybrid_dict::memusage() {
+  long n = wl.memusage() + symbcount.capacity() * sizeof(int);
+  for (unsigned i = 0; i < engines.size(); i++)
+    n += engines[i]->memusage();
+  return n;
+}
+
+void hybrid_dict::profilemem() {
+  for (unsigned i = 0; i < engines.size(); i++)
+    engines[i]->profilemem();
+}
@@ -0,0 +1,65 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef HYBRIDDICT_HH
+#define HYBRIDDICT_HH
+
+#include <vector>
+#include "symbol.hh"
+#include "dict.hh"
+#include "wordlist.hh"
+
+/**
+ * The hybrid dictionary loads every plain engine of the engine table
+ * and routes each query to the engine that is fastest for the shape
+ * of its pattern: known prefix length, known suffix length, number of
+ * fixed letters and the selectivity of the rarest fixed letter. The
+ * routing table is calibrated at load time by timing every engine on
+ * sample queries of each shape.
+ */
+
+#define HYBRID_CLASSES (4*3*4*4)
+
+class hybrid_dict : public dict {
+  vector<dict*> engines;
+  vector<const char*> names;
+  wordlist wl;
+  vector<int> symbcount;           // words per (len, pos, symbol)
+  int lencount[MAXWORDLEN];
+  unsigned char route[HYBRID_CLASSES];
+  int shapeclass(symbol *s, int len);
+  void calibrate(int nsamples);
+  void prepare();
+  void reportroutes();
+public:
+  hybrid_dict();
+  ~hybrid_dict();
+  void load(const string &fn);
+  void loadwords(const vector<string> &words);
+  symbolset findpossible(symbol *s, int len, int pos) {
+    return engines[route[shapeclass(s, len)]]->findpossible(s, len, pos);
+  }
+  long countwords(symbol *s, int len, long limit) {
+    return engines[route[shapeclass(s, len)]]->countwords(s, len, limit);
+  }
+  long memusage();
+  void profilemem();
+};
+
+#endif
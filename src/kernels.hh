@@ -0,0 +1,47 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef KERNELS_HH
+#define KERNELS_HH
+
+#include "main.hh"
+
+/**
+ * Query kernels specialized per word length. An engine writes a
+ * query as K::run<LEN> and kernelfill puts one instance per length
+ * below MAXWORDLEN into a table of K::kernel, which findpossible
+ * indexes by the slot length. With the length a constant the stack
+ * arrays get their exact size and the loops over the pattern unroll.
+ * The engines keep their generic code, used with -D kernels=0.
+ */
+
+template<class K, int LEN> struct kernelfill {
+  static void fill(typename K::kernel *table) {
+    table[LEN] = &K::template run<LEN>;
+    kernelfill<K, LEN-1>::fill(table);
+  }
+};
+
+template<class K> struct kernelfill<K, 0> {
+  static void fill(typename K::kernel *table) {
+    table[0] = &K::template run<0>;
+  }
+};
+
+#endif
@@ -0,0 +1,145 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <iostream.h>
+#include <vector>
+
+#include "letterdict.hh"
+#include "layerdict.hh"
+#include "profile.hh"
+
+//////////////////////////////////////////////////////////////////////
+// class layered_dict
+
+layered_dict::layered_dict(dict *b, bool own) : base(b), owner(own) {
+}
+
+layered_dict::~layered_dict() {
+  for (unsigned i = 0; i < blocklists.size(); i++)
+    delete blocklists[i];
+  if (!owner) return;
+  for (unsigned i = 0; i < overlays.size(); i++)
+    delete overlays[i];
+  delete base;
+}
+
+void layered_dict::addoverlay(const string &fn) {
+  cout << "Overlay " << fn << ": ";
+  dict *d = new letterdict();
+  d->load(fn);
+  overlays.push_back(d);
+}
+
+/**
+ * blocked words are kept per length together with the number of
+ * layers holding them; words found in no layer are ignored, and a
+ * word blocked more than once (in one or several lists) counts once.
+ */
+
+void layered_dict::addblocklist(const string &fn) {
+  wordlist *wl = new wordlist();
+  wl->load(fn);
+  int used = addblocklist(wl);
+  cout << "Blocklist " << fn << ": " << used << " of "
+       << wl->numwords() << " words blocked" << endl;
+}
+
+/**
+ * takes over the word list; returns the number of words blocked.
+ */
+
+int layered_dict::addblocklist(wordlist *wl) {
+  blocklists.push_back(wl);
+  int used = 0;
+  for (int i = 0; i < wl->numwords(); i++) {
+    symbol *w = (*wl)[i];
+    int len = wordlen(w);
+    if (len >= MAXWORDLEN) continue;
+    string ws(len, ' ');
+    for (int c = 0; c < len; c++) ws[c] = w[c];
+    if (blockedwords.find(ws) != blockedwords.end()) continue;
+    long n = layercount(w, len, 1L << 30);
+    if (n == 0) continue;
+    blockedwords.insert(ws);
+    blocked[len].push_back(w);
+    multiplicity[len].push_back(n);
+    used++;
+  }
+  return used;
+}
+
+long layered_dict::layercount(symbol *s, int len, long limit) {
+  long n = base->countwords(s, len, limit);
+  for (unsigned i = 0; i < overlays.size() && n < limit; i++)
+    n += overlays[i]->countwords(s, len, limit - n);
+  return n;
+}
+
+symbolset layered_dict::findpossible(symbol *s, int len, int pos) {
+  symbolset ss = base->findpossible(s, len, pos);
+  for (unsigned i = 0; i < overlays.size(); i++)
+    ss |= overlays[i]->findpossible(s, len, pos);
+  if (blocked[len].empty())
+    return ss;
+
+  // blocked words matching the pattern, by their letter at pos
+  long nblocked[MAXSYMBOLS];
+  for (int x = 0; x < MAXSYMBOLS; x++) nblocked[x] = 0;
+  for (unsigned i = 0; i < blocked[len].size(); i++)
+    if (wordmatches(blocked[len][i], s, len))
+      nblocked[blocked[len][i][pos].symbvalue()] += multiplicity[len][i];
+
+  symbol pat[len+1];
+  for (int i = 0; i <= len; i++) pat[i] = s[i];
+  for (int x = 0; x < MAXSYMBOLS; x++) {
+    if (nblocked[x] == 0 || !hassym(ss, x)) continue;
+    pat[pos] = symbol::symbolbit(symbit(x));
+    if (layercount(pat, len, nblocked[x] + 1) <= nblocked[x])
+      ss &= ~symbit(x);
+  }
+  return ss;
+}
+
+long layered_dict::countwords(symbol *s, int len, long limit) {
+  long nblocked = 0;
+  for (unsigned i = 0; i < blocked[len].size(); i++)
+    if (wordmatches(blocked[len][i], s, len))
+      nblocked += multiplicity[len][i];
+  return layercount(s, len, limit + nblocked) - nblocked;
+}
+
+long layered_dict::memusage() {
+  long n = base->memusage();
+  for (unsigned i = 0; i < overlays.size(); i++)
+    n += overlays[i]->memusage();
+  for (unsigned i = 0; i < blocklists.size(); i++)
+    n += blocklists[i]->memusage();
+  return n;
+}
+
+void layered_dict::profilemem() {
+  long n = 0;
+  for (unsigned i = 0; i < overlays.size(); i++)
+    n += overlays[i]->memusage();
+  profiler.addmem("overlays", n);
+  n = 0;
+  for (unsigned i = 0; i < blocklists.size(); i++)
+    n += blocklists[i]->memusage();
+  profiler.addmem("blocklists", n);
+}
@@ -0,0 +1,63 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef LAYERDICT_HH
+#define LAYERDICT_HH
+
+#include <set>
+#include <vector>
+#include "symbol.hh"
+#include "dict.hh"
+#include "wordlist.hh"
+
+/**
+ * layered_dict stacks small per-job word lists on top of a base
+ * dictionary without touching its index. Overlays add words and get
+ * their own small letter index; blocklists remove words. A query ORs
+ * the results of the base and the overlays. A letter is dropped again
+ * only when every word supporting it is blocked, which is decided by
+ * comparing the blocked words matching the pattern with a count query
+ * on the layers. The base and overlays are deleted with the
+ * layered_dict unless it was created as a view of shared layers.
+ */
+
+class layered_dict : public dict {
+  dict *base;
+  vector<dict*> overlays;
+  vector<wordlist*> blocklists;
+  vector<symbol*> blocked[MAXWORDLEN];
+  vector<int> multiplicity[MAXWORDLEN]; // layers holding the word
+  set<string> blockedwords;        // each blocked word once
+  bool owner;
+  long layercount(symbol *s, int len, long limit);
+public:
+  layered_dict(dict *base, bool owner = true);
+  ~layered_dict();
+  void load(const string &fn) { base->load(fn); }
+  void addoverlay(const string &fn);
+  void addoverlay(dict *d) { overlays.push_back(d); }
+  void addblocklist(const string &fn);
+  int addblocklist(wordlist *wl);
+  symbolset findpossible(symbol *s, int len, int pos);
+  long countwords(symbol *s, int len, long limit);
+  long memusage();
+  void profilemem();
+};
+
+#endif
@@ -21,6 +21,9 @@
 #include <algo.h>
 
 #include "letterdict.hh"
+#include "engines.hh"
+#include "profile.hh"
+#include "kernels.hh"
 
 
 /*
@@ -45,7 +48,43 @@
 //////////////////////////////////////////////////////////////////////
 // letterdict
 
-letterdict::letterdict() : p(0), all(0) {
+struct letterkernels {
+  typedef symbolset (*kernel)(letterdict *d, symbol *s, int len, int pos);
+  template<int LEN> static symbolset run(letterdict *d, symbol *s,
+					 int len, int pos) {
+    return d->findplain<LEN>(s, len, pos);
+  }
+};
+
+static letterkernels::kernel lettertable[MAXWORDLEN];
+
+letterdict::letterdict()
+  : p(0), all(0), wl(0), packed(false), kernels(true) {
+  if (lettertable[0] == 0)
+    kernelfill<letterkernels, MAXWORDLEN-1>::fill(lettertable);
+}
+
+letterdict::~letterdict() {
+  freeplain();
+  for (int len = 0; all && len < MAXWORDLEN; len++)
+    delete[] all[len];
+  delete[] all;
+  delete wl;
+}
+
+void letterdict::freeplain() {
+  for (int len = 0; p && len < MAXWORDLEN; len++) {
+    if (p[len] == 0) continue;
+    for (int pos = 0; pos < len; pos++) {
+      if (p[len][pos] == 0) continue;
+      for (int ch = 0; ch < MAXSYMBOLS; ch++)
+	delete p[len][pos][ch];
+      delete[] p[len][pos];
+    }
+    delete[] p[len];
+  }
+  delete[] p;
+  p = 0;
 }
 
 template<class T>
@@ -73,7 +112,7 @@ void letterdict::addword(symbol *st, int wordi) {
   // for each position in the word
   for (int pos=0; pos<wlen; pos++) {
     if (p[wlen][pos] == 0)
-      p[wlen][pos] = newptrarray<intvec>(32);
+      p[wlen][pos] = newptrarray<intvec>(MAXSYMBOLS);
     int chval = st[pos].symbvalue();
     if (p[wlen][pos][chval] == 0)
       p[wlen][pos][chval] = new intvec;
@@ -94,15 +133,67 @@ letterdict::intvec *letterdict::getintvec(int len, int pos, symbol s) {
   return p[len][pos][chval];
 }
 
+/**
+ * returns the pair list for two known letters, i < j, or 0 if the
+ * pair is not indexed.
+ */
+
+int letterdict::findpair(int len, int i, symbol si, int j, symbol sj) {
+  int key = pairkey(len, i, si.symbvalue(), j, sj.symbvalue());
+  vector<int>::iterator k = lower_bound(pairkeys.begin(), pairkeys.end(), key);
+  if (k == pairkeys.end() || *k != key) return -1;
+  return k - pairkeys.begin();
+}
+
+letterdict::intvec *letterdict::getpairvec(int len, int i, symbol si,
+					  int j, symbol sj) {
+  int k = findpair(len, i, si, j, sj);
+  return k < 0 ? 0 : &pairlists[k];
+}
+
 symbolset letterdict::findpossible(symbol *s, int len, int pos) {
   if (len == 1) return wl->allalpha;
+  if (packed) return findpacked(s, len, pos);
+  if (kernels) return lettertable[len](this, s, len, pos);
+  return findplain<0>(s, len, pos);
+}
+
+/**
+ * intersects the plain lists. LEN is the word length, fixed at
+ * compile time for the kernels, or 0 for the generic version which
+ * takes it from len.
+ */
 
-  intvec *chpset[len];
+template<int LEN>
+symbolset letterdict::findplain(symbol *s, int len, int pos) {
+  const int n = LEN ? LEN : len;
+  intvec *chpset[LEN ? LEN : MAXWORDLEN];
   int nsets = 0;
+  int fixed[LEN ? LEN : MAXWORDLEN], nfixed = 0;
 
-  for (int i=0;i<len;i++)
+  for (int i=0;i<n;i++)
     if (s[i] != symbol::empty)
-      chpset[nsets++] = getintvec(len, i, s[i]);
+      fixed[nfixed++] = i;
+
+  // start from the shortest pair list, if any pair is indexed
+  int pi = -1, pj = -1;
+  if (nfixed >= 2 && !pairkeys.empty()) {
+    intvec *best = 0;
+    for (int a = 0; a < nfixed; a++)
+      for (int b = a+1; b < nfixed; b++) {
+	intvec *v = getpairvec(len, fixed[a], s[fixed[a]],
+			       fixed[b], s[fixed[b]]);
+	if (v && (best == 0 || v->size() < best->size())) {
+	  best = v; pi = fixed[a]; pj = fixed[b];
+	}
+      }
+    if (best)
+      chpset[nsets++] = best;
+  }
+
+  for (int f = 0; f < nfixed; f++)
+    if (fixed[f] != pi && fixed[f] != pj)
+      chpset[nsets++] = getintvec(len, fixed[f], s[fixed[f]]);
 
   // cout << nsets << " sets\n";
   if (nsets == 0) {
@@ -114,7 +205,7 @@ symbolset letterdict::findpossible(symbol *s, int len, int pos) {
 
   symbolset ss = 0;
 
-  intvec::iterator it[nsets];
+  intvec::iterator it[LEN ? LEN : MAXWORDLEN];
   for (int i=0;i<nsets; i++) {
     it[i] = chpset[i]->begin();
     if (it[i] == chpset[i]->end())
@@ -159,15 +250,464 @@ symbolset letterdict::findpossible(symbol *s, int len, int pos) {
   return ss;
 }
 
+/**
+ * counts the words matching s by scanning the shortest list of a
+ * known letter and comparing the words themselves.
+ */
+
+long letterdict::countwords(symbol *s, int len, long limit) {
+  if (len >= MAXWORDLEN) return 0;
+  int best = -1;
+  long bestn = 0;
+  for (int i = 0; i < len; i++) {
+    if (s[i] == symbol::empty) continue;
+    long n;
+    if (packed) {
+      int li = plistindex[(len*MAXWORDLEN + i)*MAXSYMBOLS + s[i].symbvalue()];
+      n = li < 0 ? 0 : plists[li].n;
+    } else
+      n = getintvec(len, i, s[i])->size();
+    if (n == 0) return 0;
+    if (best < 0 || n < bestn) { best = i; bestn = n; }
+  }
+
+  long count = 0;
+  if (best >= 0 && packed) {
+    packedcursor c;
+    c.start(&plists[plistindex[(len*MAXWORDLEN + best)*MAXSYMBOLS
+			       + s[best].symbvalue()]]);
+    for (; !c.end() && count < limit; c.next())
+      if (wordmatches((*wl)[lenwords[len][c.value()]], s, len)) count++;
+    return count;
+  }
+
+  // the index's own list when there is one, otherwise one built here
+  intvec built;
+  const intvec *words = &built;
+  if (best < 0) {
+    for (int w = 0; w < wl->numwords(); w++)
+      if (!duplicate[w] && wordlen((*wl)[w]) == len) built.push_back(w);
+  } else
+    words = getintvec(len, best, s[best]);
+
+  for (unsigned k = 0; k < words->size() && count < limit; k++)
+    if (wordmatches((*wl)[(*words)[k]], s, len)) count++;
+  return count;
+}
+
 void letterdict::load(const string &fn) {
   cout << "Loading wordlist and building dictionary... " << flush;
 
+  profiler.begin("load");
   wl = new wordlist();
   wl->load(fn);
 
-  int nwords = wl->numwords();
-  for (int i=0; i<nwords; i++)
-    addword((*wl)[i], i);
+  profiler.begin("index");
+  index();
 
   cout << "ok" << endl;
+  if (dictopts.pairs)
+    cout << "Position pair index: " << pairkeys.size() << " lists, "
+	 << pairbytes() / 1024 << " KB" << endl;
+  if (dictopts.packed) {
+    profiler.begin("pack");
+    long before = postingbytes() + pairbytes();
+    long npostings = pack();
+    if (npostings)
+      cout << "Packed posting lists: " << npostings << " postings, "
+	   << double(before) / npostings << " -> "
+	   << double(packedbytes()) / npostings << " bytes per posting"
+	   << endl;
+  }
+}
+
+void letterdict::loadwords(const vector<string> &words) {
+  wl = new wordlist();
+  addwords(words);
+  finishwords();
+}
+
+void letterdict::addwords(const vector<string> &words) {
+  if (!wl)
+    wl = new wordlist();
+  for (unsigned i = 0; i < words.size(); i++)
+    wl->addword(words[i]);
+}
+
+void letterdict::finishwords() {
+  index();
+  if (dictopts.packed)
+    pack();
+}
+
+static int wordcmp(symbol *a, symbol *b) {
+  while ((*a == *b) && !(*a == symbol::outside)) { a++; b++; }
+  return a->symbvalue() - b->symbvalue();
+}
+
+struct wordorder {
+  wordlist *wl;
+  bool operator()(int a, int b) const {
+    int c = wordcmp((*wl)[a], (*wl)[b]);
+    return c ? c < 0 : a < b;
+  }
+};
+
+struct paircand {
+  int key, n;
+  long saved;
+  bool operator<(const paircand &o) const { return saved > o.saved; }
+};
+
+/**
+ * the words grouped by length, and the per length results of the
+ * index build threads. Every job below works on one length and writes
+ * only to that length's lists, which are merged in length order.
+ */
+
+struct letterbuild {
+  letterdict *ld;
+  vector<vector<int> > bylen;        // word numbers of each length
+  vector<long> weight;               // build cost of each length
+  vector<vector<int> > dups;         // duplicates found
+  vector<vector<paircand> > cands;   // pair list candidates
+  vector<int> local;                 // word number within its length
+  vector<vector<packedlist> > packs; // packed single letter lists
+  vector<vector<int> > packkeys;     // their plistindex keys
+  vector<long> npostings;
+
+  letterbuild(letterdict *d);
+  static void finddups(void *arg, int len);
+  static void addwords(void *arg, int len);
+  static void countpairs(void *arg, int len);
+  static void fillpairs(void *arg, int len);
+  static void packlists(void *arg, int len);
+  static void packpairs(void *arg, int len);
+};
+
+// words too long for the index are left out
+letterbuild::letterbuild(letterdict *d)
+  : ld(d), bylen(MAXWORDLEN), weight(MAXWORDLEN, 0), dups(MAXWORDLEN),
+    cands(MAXWORDLEN), packs(MAXWORDLEN), packkeys(MAXWORDLEN),
+    npostings(MAXWORDLEN, 0) {
+  int nwords = d->wl->numwords();
+  for (int w = 0; w < nwords; w++) {
+    int len = wordlen((*d->wl)[w]);
+    if (len >= MAXWORDLEN) continue;
+    bylen[len].push_back(w);
+    weight[len] += len;
+  }
+}
+
+void letterbuild::finddups(void *arg, int len) {
+  letterbuild *b = (letterbuild*)arg;
+  wordlist *wl = b->ld->wl;
+  vector<int> order(b->bylen[len]);
+  wordorder cmp;
+  cmp.wl = wl;
+  sort(order.begin(), order.end(), cmp);
+  for (unsigned i=1; i<order.size(); i++)
+    if (wordcmp((*wl)[order[i-1]], (*wl)[order[i]]) == 0)
+      b->dups[len].push_back(order[i]);
+}
+
+void letterbuild::addwords(void *arg, int len) {
+  letterbuild *b = (letterbuild*)arg;
+  letterdict *ld = b->ld;
+  vector<int> &ws = b->bylen[len];
+  for (unsigned i = 0; i < ws.size(); i++)
+    if (!ld->duplicate[ws[i]])
+      ld->addword((*ld->wl)[ws[i]], ws[i]);
+}
+
+/**
+ * indexes every word once; later copies of a word (the file may hold
+ * the same word in different cases) are marked as duplicates. Copies
+ * have the same length, so both steps go length by length on the -D
+ * threads=<n> index build threads, with the same lists as one thread.
+ */
+
+void letterdict::index() {
+  kernels = dictopts.kernels;
+  int nwords = wl->numwords();
+  letterbuild b(this);
+  duplicate.assign(nwords, false);
+  forlengths(letterbuild::finddups, &b, b.weight);
+  for (int len = 0; len < MAXWORDLEN; len++)
+    for (unsigned i = 0; i < b.dups[len].size(); i++)
+      duplicate[b.dups[len][i]] = true;
+
+  if (p == 0)
+    p = newptrarray<intvec**>(MAXWORDLEN);
+  if (all == 0)
+    all = newptrarray<symbolset>(MAXWORDLEN);
+  forlengths(letterbuild::addwords, &b, b.weight);
+  if (dictopts.pairs)
+    buildpairs(b);
+}
+
+/**
+ * replaces the plain lists by packed lists of length-local word
+ * numbers. Returns the number of postings packed.
+ */
+
+void letterbuild::packlists(void *arg, int len) {
+  letterbuild *b = (letterbuild*)arg;
+  letterdict::intvec ****p = b->ld->p;
+  if (p[len] == 0) return;
+  vector<int> v;
+  for (int pos = 0; pos < len; pos++) {
+    if (p[len][pos] == 0) continue;
+    for (int ch = 0; ch < MAXSYMBOLS; ch++) {
+      letterdict::intvec *l = p[len][pos][ch];
+      if (l == 0) continue;
+      v.resize(l->size());
+      for (unsigned k = 0; k < l->size(); k++)
+	v[k] = b->local[(*l)[k]];
+      b->packkeys[len].push_back((len*MAXWORDLEN + pos)*MAXSYMBOLS + ch);
+      b->packs[len].push_back(packedlist());
+      b->packs[len].back().pack(v);
+      b->npostings[len] += v.size();
+    }
+  }
+}
+
+// the pair lists of one length; the keys are sorted by length
+void letterbuild::packpairs(void *arg, int len) {
+  letterbuild *b = (letterbuild*)arg;
+  letterdict *ld = b->ld;
+  vector<int> &keys = ld->pairkeys;
+  int from = lower_bound(keys.begin(), keys.end(),
+			 letterdict::pairkey(len, 0, 0, 0, 0)) - keys.begin();
+  int to = lower_bound(keys.begin(), keys.end(),
+		       letterdict::pairkey(len+1, 0, 0, 0, 0)) - keys.begin();
+  vector<int> v;
+  for (int i = from; i < to; i++) {
+    letterdict::intvec &l = ld->pairlists[i];
+    v.resize(l.size());
+    for (unsigned k = 0; k < v.size(); k++)
+      v[k] = b->local[l[k]];
+    ld->ppairs[i].pack(v);
+    b->npostings[len] += v.size();
+  }
+}
+
+long letterdict::pack() {
+  int nwords = wl->numwords();
+  letterbuild b(this);
+  b.local.assign(nwords, -1);
+  for (int len = 0; len < MAXWORDLEN; len++)
+    for (unsigned i = 0; i < b.bylen[len].size(); i++) {
+      int w = b.bylen[len][i];
+      if (duplicate[w]) continue;
+      b.local[w] = lenwords[len].size();
+      lenwords[len].push_back(w);
+    }
+
+  plistindex.assign(MAXWORDLEN * MAXWORDLEN * MAXSYMBOLS, -1);
+  if (p)
+    forlengths(letterbuild::packlists, &b, b.weight);
+  ppairs.resize(pairlists.size());
+  forlengths(letterbuild::packpairs, &b, b.weight);
+
+  long npostings = 0;
+  for (int len = 0; len < MAXWORDLEN; len++) {
+    for (unsigned k = 0; k < b.packs[len].size(); k++) {
+      plistindex[b.packkeys[len][k]] = plists.size();
+      plists.push_back(b.packs[len][k]);
+    }
+    npostings += b.npostings[len];
+  }
+  vector<intvec>().swap(pairlists);
+  freeplain();
+  packed = true;
+  return npostings;
+}
+
+symbolset letterdict::findpacked(symbol *s, int len, int pos) {
+  int fixed[len], nfixed = 0;
+  for (int i=0;i<len;i++)
+    if (s[i] != symbol::empty)
+      fixed[nfixed++] = i;
+
+  if (nfixed == 0) {
+    if (all[len] == 0)
+      return 0;
+    return all[len][pos];
+  }
+
+  packedcursor cur[len];
+  int nsets = 0;
+
+  // start from the shortest pair list, if any pair is indexed
+  int best = -1, pi = -1, pj = -1;
+  for (int a = 0; a < nfixed && !pairkeys.empty(); a++)
+    for (int b = a+1; b < nfixed; b++) {
+      int k = findpair(len, fixed[a], s[fixed[a]], fixed[b], s[fixed[b]]);
+      if (k >= 0 && (best < 0 || ppairs[k].n < ppairs[best].n)) {
+	best = k; pi = fixed[a]; pj = fixed[b];
+      }
+    }
+  if (best >= 0)
+    cur[nsets++].start(&ppairs[best]);
+
+  for (int f = 0; f < nfixed; f++) {
+    if (fixed[f] == pi || fixed[f] == pj) continue;
+    int li = plistindex[(len*MAXWORDLEN + fixed[f])*MAXSYMBOLS + s[fixed[f]].symbvalue()];
+    if (li < 0) return 0;
+    cur[nsets++].start(&plists[li]);
+  }
+
+  for (int k = 0; k < nsets; k++)
+    if (cur[k].end()) return 0;
+
+  // leapfrog intersection: seek every list to the candidate word
+  symbolset ss = 0;
+  int cand = cur[0].value();
+  while (1) {
+    bool same = true;
+    for (int k = 0; k < nsets; k++) {
+      cur[k].seek(cand);
+      if (cur[k].end()) return ss;
+      if (cur[k].value() != cand) {
+	cand = cur[k].value();
+	same = false;
+      }
+    }
+    if (same) {
+      ss |= (*wl)[lenwords[len][cand]][pos].getsymbolset();
+      cur[0].next();
+      if (cur[0].end()) return ss;
+      cand = cur[0].value();
+    }
+  }
+}
+
+/**
+ * builds pair lists for letter pairs whose single lists are both at
+ * least dictopts.pairmin long. Candidates are ranked by the postings
+ * an intersection saves and taken until dictopts.pairmem is spent.
+ */
+
+void letterbuild::countpairs(void *arg, int len) {
+  letterbuild *b = (letterbuild*)arg;
+  letterdict *ld = b->ld;
+  if (len < 2 || ld->p[len] == 0) return;
+  vector<int> cnt(len*len*MAXSYMBOLS*MAXSYMBOLS, 0);
+  bool any = false;
+  vector<int> &ws = b->bylen[len];
+  for (unsigned w = 0; w < ws.size(); w++) {
+    symbol *st = (*ld->wl)[ws[w]];
+    if (ld->duplicate[ws[w]]) continue;
+    for (int i = 0; i < len; i++) {
+      if (ld->getintvec(len, i, st[i])->size() < unsigned(dictopts.pairmin))
+	continue;
+      for (int j = i+1; j < len; j++)
+	if (ld->getintvec(len, j, st[j])->size() >= unsigned(dictopts.pairmin)) {
+	  cnt[((i*len + j)*MAXSYMBOLS + st[i].symbvalue())*MAXSYMBOLS
+	      + st[j].symbvalue()]++;
+	  any = true;
+	}
+    }
+  }
+  if (!any) return;
+  letterdict::intvec ****p = ld->p;
+  for (int i = 0; i < len; i++)
+    for (int j = i+1; j < len; j++)
+      for (int si = 0; si < MAXSYMBOLS; si++)
+	for (int sj = 0; sj < MAXSYMBOLS; sj++) {
+	  int n = cnt[((i*len + j)*MAXSYMBOLS + si)*MAXSYMBOLS + sj];
+	  if (n == 0) continue;
+	  paircand c;
+	  c.key = letterdict::pairkey(len, i, si, j, sj);
+	  c.n = n;
+	  c.saved = long(p[len][i][si]->size()) + p[len][j][sj]->size() - n;
+	  b->cands[len].push_back(c);
+	}
+}
+
+// word numbers are visited in order, so every list stays sorted
+void letterbuild::fillpairs(void *arg, int len) {
+  letterbuild *b = (letterbuild*)arg;
+  letterdict *ld = b->ld;
+  vector<int> &ws = b->bylen[len];
+  for (unsigned w = 0; w < ws.size(); w++) {
+    symbol *st = (*ld->wl)[ws[w]];
+    if (ld->duplicate[ws[w]]) continue;
+    for (int i = 0; i < len; i++)
+      for (int j = i+1; j < len; j++) {
+	letterdict::intvec *v = ld->getpairvec(len, i, st[i], j, st[j]);
+	if (v) v->push_back(ws[w]);
+      }
+  }
+}
+
+void letterdict::buildpairs(letterbuild &build) {
+  forlengths(letterbuild::countpairs, &build, build.weight);
+  vector<paircand> cand;
+  for (int len = 0; len < MAXWORDLEN; len++)
+    cand.insert(cand.end(), build.cands[len].begin(), build.cands[len].end());
+
+  sort(cand.begin(), cand.end());
+  long bytes = 0;
+  for (unsigned c = 0; c < cand.size(); c++) {
+    long b = sizeof(int) + sizeof(intvec) + cand[c].n * sizeof(int);
+    if (bytes + b > dictopts.pairmem) continue;
+    bytes += b;
+    pairkeys.push_back(cand[c].key);
+  }
+  sort(pairkeys.begin(), pairkeys.end());
+  pairlists.resize(pairkeys.size());
+  if (pairkeys.empty()) return;
+  forlengths(letterbuild::fillpairs, &build, build.weight);
+}
+
+long letterdict::postingbytes() {
+  long n = 0;
+  for (int len = 0; p && len < MAXWORDLEN; len++) {
+    if (p[len] == 0) continue;
+    n += len * (sizeof(intvec**) + sizeof(symbolset));
+    for (int pos = 0; pos < len; pos++) {
+      if (p[len][pos] == 0) continue;
+      n += MAXSYMBOLS * sizeof(intvec*);
+      for (int ch = 0; ch < MAXSYMBOLS; ch++)
+	if (p[len][pos][ch])
+	  n += sizeof(intvec) + p[len][pos][ch]->capacity() * sizeof(int);
+    }
+  }
+  return n;
+}
+
+long letterdict::pairbytes() {
+  long n = pairkeys.capacity() * sizeof(int)
+    + pairlists.capacity() * sizeof(intvec);
+  for (unsigned i = 0; i < pairlists.size(); i++)
+    n += pairlists[i].capacity() * sizeof(int);
+  return n;
+}
+
+long letterdict::packedbytes() {
+  long n = plistindex.capacity() * sizeof(int);
+  for (unsigned i = 0; i < plists.size(); i++)
+    n += plists[i].memusage();
+  for (unsigned i = 0; i < ppairs.size(); i++)
+    n += ppairs[i].memusage();
+  for (int len = 0; len < MAXWORDLEN; len++)
+    n += lenwords[len].capacity() * sizeof(int);
+  return n;
+}
+
+long letterdict::memusage() {
+  return postingbytes() + pairbytes() + packedbytes()
+    + (wl ? wl->memusage() : 0);
+}
+
+void letterdict::profilemem() {
+  profiler.addmem("posting lists", postingbytes());
+  if (!pairlists.empty())
+    profiler.addmem("pair index", pairbytes());
+  if (packed)
+    profiler.addmem("packed posting lists", packedbytes());
+  if (wl)
+    profiler.addmem("word storage", wl->memusage());
 }
@@ -17,22 +17,79 @@
  * 02111-1307, USA. 
  **/
 
+#ifndef LETTERDICT_HH
+#define LETTERDICT_HH
+
 #include <set>
 #include <vector>
 #include "symbol.hh"
 #include "dict.hh"
 #include "wordlist.hh"
+#include "postings.hh"
+
+/**
+ * The letter index keeps a sorted list of word numbers for every
+ * (length, position, letter) and intersects the lists of the known
+ * letters of a pattern. Optionally (-D pairs=1) it also keeps lists
+ * for (length, position, letter, position, letter) where both single
+ * lists are long; a query with two or more known letters then starts
+ * from the shortest such pair list instead of two long single lists.
+ *
+ * With -D packed=1 all lists are compressed after the build (see
+ * postings.hh) and hold word numbers local to the word length, which
+ * keeps the deltas small. Queries then intersect the packed lists
+ * directly, decoding block by block.
+ */
+
+struct letterbuild;
 
 class letterdict : public dict {
+  friend struct letterkernels;
+  friend struct letterbuild;
   typedef vector<int> intvec;
   intvec ****p;
   symbolset **all;
   wordlist *wl;
+  vector<bool> duplicate;          // word is a copy of an earlier one
   static intvec emptyvec;
+  vector<int> pairkeys;            // sorted
+  vector<intvec> pairlists;        // parallel to pairkeys
+  static int pairkey(int len, int i, int si, int j, int sj) {
+    return (((len*MAXWORDLEN + i)*MAXSYMBOLS + si)*MAXWORDLEN + j)*MAXSYMBOLS
+      + sj;
+  }
+  void buildpairs(letterbuild &build);
+  int findpair(int len, int i, symbol si, int j, symbol sj);
+  intvec *getpairvec(int len, int i, symbol si, int j, symbol sj);
+  void freeplain();
+
+  // packed form
+  bool packed;
+  vector<packedlist> plists;       // single letter lists
+  vector<int> plistindex;          // (len, pos, letter) -> plists or -1
+  vector<packedlist> ppairs;       // parallel to pairkeys
+  vector<int> lenwords[MAXWORDLEN]; // local -> global word number
+  long pack();
+  void index();
+  symbolset findpacked(symbol *, int len, int pos);
+  bool kernels;       // use the per-length query kernels
+  template<int LEN> symbolset findplain(symbol *, int len, int pos);
 public:
   letterdict();
+  ~letterdict();
   void addword(symbol *i, int wordi);
   intvec *getintvec(int len, int pos, symbol s);
   symbolset findpossible(symbol *, int len, int pos);
+  long countwords(symbol *s, int len, long limit);
   void load(const string &fn);
+  void loadwords(const vector<string> &words);
+  void addwords(const vector<string> &words);
+  void finishwords();
+  long memusage();
+  long postingbytes();
+  long pairbytes();
+  long packedbytes();
+  void profilemem();
 };
+
+#endif
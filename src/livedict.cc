@@ -0,0 +1,365 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <unistd.h>
+#include <ctype.h>
+#include <iostream.h>
+#include <fstream.h>
+#include <string>
+#include <algo.h>
+
+#include "wordlist.hh"
+#include "letterdict.hh"
+#include "livedict.hh"
+
+//////////////////////////////////////////////////////////////////////
+// class live_dict
+
+live_dict::live_dict(dict *d, const string &fn, dictengine *e)
+  : engine(e), current(0), epoch(1), slots(0), dirty(0), merging(false),
+    mergethread(false), mergefrom(0), updating(false), stopupdates(false),
+    added(0), removed(0), publications(0), merges(0) {
+  pthread_mutex_init(&lock, 0);
+  pthread_key_create(&readerkey, freereader);
+  for (int r = 0; r < MAXREADERS; r++)
+    active[r] = 0;
+
+  wordlist wl;
+  wl.load(fn);
+  for (int i = 0; i < wl.numwords(); i++) {
+    string w;
+    for (symbol *s = wl[i]; *s != symbol::outside; s++)
+      w += char(*s);
+    words.insert(w);
+  }
+
+  base = new segment;
+  base->d = d;
+  base->refs = 1;
+  pthread_mutex_lock(&lock);
+  publishlocked(false);
+  pthread_mutex_unlock(&lock);
+}
+
+live_dict::~live_dict() {
+  stopupdating();
+  if (mergethread)
+    pthread_join(merger, 0);
+  pthread_mutex_lock(&lock);
+  freesnapshot(current);
+  for (unsigned i = 0; i < retired.size(); i++)
+    freesnapshot(retired[i]);
+  release(base);
+  for (unsigned i = 0; i < deltas.size(); i++)
+    release(deltas[i]);
+  pthread_mutex_unlock(&lock);
+  pthread_mutex_destroy(&lock);
+  pthread_key_delete(readerkey);
+}
+
+/**
+ * returns the reader slot of the calling thread, claiming a free one
+ * on its first query. The slot is returned when the thread exits.
+ */
+
+int live_dict::reader() {
+  readerslot *rs = (readerslot*)pthread_getspecific(readerkey);
+  if (rs) return rs->slot;
+  while (1) {
+    unsigned long long used = slots;
+    if (used == ~0ULL)
+      throw error("Too many dictionary reader threads");
+    int r = 0;
+    while (used & (1ULL << r)) r++;
+    if (__sync_bool_compare_and_swap(&slots, used, used | (1ULL << r))) {
+      rs = new readerslot;
+      rs->ld = this;
+      rs->slot = r;
+      pthread_setspecific(readerkey, rs);
+      return r;
+    }
+  }
+}
+
+void live_dict::freereader(void *p) {
+  readerslot *rs = (readerslot*)p;
+  __sync_fetch_and_and(&rs->ld->slots, ~(1ULL << rs->slot));
+  delete rs;
+}
+
+symbolset live_dict::findpossible(symbol *s, int len, int pos) {
+  int r = reader();
+  active[r] = epoch + 1;
+  __sync_synchronize();
+  symbolset ss = current->d->findpossible(s, len, pos);
+  __sync_synchronize();
+  active[r] = 0;
+  return ss;
+}
+
+long live_dict::countwords(symbol *s, int len, long limit) {
+  int r = reader();
+  active[r] = epoch + 1;
+  __sync_synchronize();
+  long n = current->d->countwords(s, len, limit);
+  __sync_synchronize();
+  active[r] = 0;
+  return n;
+}
+
+//////////////////////////////////////////////////////////////////////
+// updates
+
+bool live_dict::cleanword(string &w) {
+  if (w.empty() || w.length() >= MAXWORDLEN)
+    return false;
+  for (unsigned i = 0; i < w.length(); i++) {
+    if (!wordchar(w[i]))
+      return false;
+    w[i] = tolower(w[i]);
+  }
+  return true;
+}
+
+void live_dict::add_word(const string &word) {
+  string w(word);
+  if (!cleanword(w)) return;
+  pthread_mutex_lock(&lock);
+  if (words.insert(w).second) {
+    tombstones.erase(w);
+    pending.push_back(w);
+    added++;
+    if (++dirty >= LIVEBATCH)
+      publishlocked(true);
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+void live_dict::remove_word(const string &word) {
+  string w(word);
+  if (!cleanword(w)) return;
+  pthread_mutex_lock(&lock);
+  if (words.erase(w)) {
+    vector<string>::iterator p = find(pending.begin(), pending.end(), w);
+    if (p != pending.end())
+      pending.erase(p);
+    tombstones.insert(w);
+    removedsince.insert(w);
+    removed++;
+    if (++dirty >= LIVEBATCH)
+      publishlocked(true);
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+void live_dict::publish() {
+  pthread_mutex_lock(&lock);
+  publishlocked(true);
+  pthread_mutex_unlock(&lock);
+}
+
+/**
+ * turns the pending words into a delta segment, swaps in a new
+ * snapshot and retires the old one. Called with the lock held.
+ */
+
+void live_dict::publishlocked(bool maymerge) {
+  if (!pending.empty()) {
+    segment *s = new segment;
+    s->d = new letterdict();
+    s->d->loadwords(pending);
+    s->refs = 1;
+    deltas.push_back(s);
+    pending.clear();
+  }
+
+  snapshot *sn = new snapshot;
+  sn->d = new layered_dict(base->d, false);
+  sn->segs.push_back(base);
+  base->refs++;
+  for (unsigned i = 0; i < deltas.size(); i++) {
+    sn->d->addoverlay(deltas[i]->d);
+    sn->segs.push_back(deltas[i]);
+    deltas[i]->refs++;
+  }
+  if (!tombstones.empty()) {
+    wordlist *wl = new wordlist();
+    for (set<string>::iterator t = tombstones.begin(); t != tombstones.end(); t++)
+      wl->addword(*t);
+    sn->d->addblocklist(wl);
+  }
+
+  snapshot *old = current;
+  current = sn;
+  __sync_synchronize();
+  if (old) {
+    old->retired = __sync_add_and_fetch(&epoch, 1);
+    retired.push_back(old);
+  }
+  publications++;
+  dirty = 0;
+  reclaim();
+
+  if (maymerge && !merging && (deltas.size() >= LIVEMERGE ||
+				tombstones.size() >= LIVETOMBSTONES)) {
+    if (mergethread)
+      pthread_join(merger, 0);
+    merging = mergethread = true;
+    mergefrom = deltas.size();
+    mergewords.assign(words.begin(), words.end());
+    removedsince.clear();
+    if (pthread_create(&merger, 0, mergemain, this) != 0) {
+      // the deltas and tombstones stay; a later publication retries
+      merging = mergethread = false;
+      mergewords.clear();
+    }
+  }
+}
+
+/**
+ * frees the retired snapshots no reader can be using: every reader is
+ * idle or entered after the snapshot was replaced.
+ */
+
+void live_dict::reclaim() {
+  unsigned i = 0;
+  while (i < retired.size()) {
+    bool busy = false;
+    for (int r = 0; r < MAXREADERS; r++) {
+      unsigned long a = active[r];
+      if (a && a <= retired[i]->retired)
+	busy = true;
+    }
+    if (busy) {
+      i++;
+      continue;
+    }
+    freesnapshot(retired[i]);
+    retired.erase(retired.begin() + i);
+  }
+}
+
+void live_dict::freesnapshot(snapshot *sn) {
+  if (sn == 0) return;
+  delete sn->d;
+  for (unsigned i = 0; i < sn->segs.size(); i++)
+    release(sn->segs[i]);
+  delete sn;
+}
+
+void live_dict::release(segment *s) {
+  if (--s->refs == 0) {
+    delete s->d;
+    delete s;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+// background merge
+
+void *live_dict::mergemain(void *p) {
+  ((live_dict*)p)->merge();
+  return 0;
+}
+
+/**
+ * rebuilds the base from the words live when the merge started. The
+ * deltas published since then stay on top of the new base, and only
+ * tombstones of words removed since then are still needed.
+ */
+
+void live_dict::merge() {
+  dict *d = engine->create();
+  d->loadwords(mergewords);
+
+  pthread_mutex_lock(&lock);
+  segment *s = new segment;
+  s->d = d;
+  s->refs = 1;
+  release(base);
+  base = s;
+  for (unsigned i = 0; i < mergefrom; i++)
+    release(deltas[i]);
+  deltas.erase(deltas.begin(), deltas.begin() + mergefrom);
+  set<string> keep;
+  for (set<string>::iterator t = tombstones.begin(); t != tombstones.end(); t++)
+    if (removedsince.count(*t))
+      keep.insert(*t);
+  tombstones.swap(keep);
+  mergewords.clear();
+  merges++;
+  merging = false;
+  publishlocked(false);
+  pthread_mutex_unlock(&lock);
+}
+
+//////////////////////////////////////////////////////////////////////
+// update feed
+
+/**
+ * applies `+word' and `-word' lines from a file in a background
+ * thread, pausing dictopts.liveinterval msecs after every batch.
+ */
+
+void live_dict::startupdates(const string &fn) {
+  updatefile = fn;
+  stopupdates = false;
+  if (pthread_create(&updater, 0, updatemain, this) != 0)
+    throw error("Failed to start update thread");
+  updating = true;
+}
+
+void live_dict::stopupdating() {
+  if (!updating) return;
+  stopupdates = true;
+  pthread_join(updater, 0);
+  updating = false;
+}
+
+void *live_dict::updatemain(void *p) {
+  ((live_dict*)p)->applyupdates();
+  return 0;
+}
+
+void live_dict::applyupdates() {
+  ifstream f(updatefile.c_str());
+  if (!f.is_open()) {
+    cout << "Failed to open update file" << endl;
+    return;
+  }
+  string ln;
+  int n = 0;
+  while (!stopupdates && getline(f, ln)) {
+    if (ln.length() < 2) continue;
+    if (ln[0] == '+')
+      add_word(ln.substr(1));
+    else if (ln[0] == '-')
+      remove_word(ln.substr(1));
+    if ((++n % LIVEBATCH == 0) && dictopts.liveinterval > 0)
+      usleep(dictopts.liveinterval * 1000);
+  }
+  publish();
+}
+
+long live_dict::memusage() {
+  pthread_mutex_lock(&lock);
+  long n = current->d->memusage();
+  pthread_mutex_unlock(&lock);
+  return n;
+}
@@ -0,0 +1,117 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef LIVEDICT_HH
+#define LIVEDICT_HH
+
+#include <pthread.h>
+#include <set>
+#include <vector>
+#include "symbol.hh"
+#include "dict.hh"
+#include "engines.hh"
+#include "layerdict.hh"
+
+#define LIVEBATCH 32       // pending updates that trigger a publication
+#define LIVEMERGE 8        // delta segments that trigger a merge
+#define LIVETOMBSTONES 1024 // tombstones that trigger a merge
+#define MAXREADERS 64
+
+/**
+ * live_dict takes word additions and removals while other threads
+ * keep querying. Added words collect in a pending list and become a
+ * small delta segment (a letter index) when published; removed words
+ * become tombstones. Every publication builds a new immutable
+ * snapshot, a layered_dict view of the base, the deltas and the
+ * tombstones, and swaps it in. When the deltas or the tombstones pile
+ * up, a background thread rebuilds the base from the live word set
+ * and publishes the result together with whatever arrived during the
+ * merge.
+ *
+ * Readers announce the epoch they entered in; a retired snapshot is
+ * freed only once no reader can still be inside it. Updates are
+ * serialized by a mutex and must come from one thread at a time.
+ */
+
+class live_dict : public dict {
+  struct segment {
+    dict *d;
+    int refs;
+  };
+  struct snapshot {
+    layered_dict *d;
+    vector<segment*> segs;
+    unsigned long retired;         // epoch it was replaced in
+  };
+
+  dictengine *engine;              // builds merged bases
+  pthread_mutex_t lock;
+  snapshot * volatile current;
+  volatile unsigned long epoch;
+  volatile unsigned long active[MAXREADERS]; // entry epoch + 1, 0 = idle
+  volatile unsigned long long slots; // reader slots in use
+  pthread_key_t readerkey;
+  struct readerslot {
+    live_dict *ld;
+    int slot;
+  };
+  static void freereader(void *);
+
+  segment *base;
+  vector<segment*> deltas;
+  set<string> words, tombstones, removedsince;
+  vector<string> pending;
+  vector<snapshot*> retired;
+  int dirty;                       // updates since the last publication
+  bool merging, mergethread;
+  pthread_t merger;
+  unsigned mergefrom;
+  vector<string> mergewords;
+
+  pthread_t updater;
+  bool updating;
+  volatile bool stopupdates;
+  string updatefile;
+
+  int reader();
+  void publishlocked(bool maymerge);
+  void freesnapshot(snapshot *sn);
+  void reclaim();
+  void release(segment *s);
+  static void *mergemain(void *);
+  void merge();
+  static void *updatemain(void *);
+  void applyupdates();
+  static bool cleanword(string &w);
+public:
+  long added, removed, publications, merges;
+  live_dict(dict *base, const string &fn, dictengine *e);
+  ~live_dict();
+  void load(const string &fn) {}
+  void add_word(const string &w);
+  void remove_word(const string &w);
+  void publish();
+  void startupdates(const string &fn);
+  void stopupdating();
+  symbolset findpossible(symbol *s, int len, int pos);
+  long countwords(symbol *s, int len, long limit);
+  long memusage();
+};
+
+#endif
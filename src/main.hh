@@ -34,8 +34,9 @@ public:
 struct setup_s {
   typedef enum { simple_format, ascii_format } output_format_t;
   typedef enum { prefixwalker, floodwalker } walker_t;
-  typedef enum { btreedict, letterdict } dict_t;
+  typedef enum { btreedict, letterdict, hybriddict, bitreedict } dict_t;
   typedef enum { noformat, generalgrid, squaregrid } gridformat_t;
+  typedef enum { nostats, textstats, jsonstats } statsformat_t;
   output_format_t output_format;
   walker_t walkertype;
   dict_t dictstyle;
@@ -46,6 +47,19 @@ struct setup_s {
   bool setseed;
   int seed;
   bool debuginfo;
+  string benchopts;
+  string querylog;
+  string corpusfile;
+  statsformat_t statsformat;
+  int progressinterval;
+  bool perfcounters;
+  string tracefile;
+  int probes;
+  string dictopts;
+  int threads;
+  int treewidth;
+  int depsample;
+  bool pipeline;
 };
 
 extern setup_s setup;
@@ -0,0 +1,144 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <iostream.h>
+#include <vector>
+
+#include "wordlist.hh"
+#include "pairfilter.hh"
+
+pairfilter *activefilter = 0;
+
+static inline int pairkey(int len, int i, int si, int j, int sj) {
+  return (((len*MAXWORDLEN + i)*MAXSYMBOLS + si)*MAXWORDLEN + j)*MAXSYMBOLS
+    + sj;
+}
+
+//////////////////////////////////////////////////////////////////////
+// class pairfilter
+
+pairfilter::pairfilter(long bytes)
+  : alpha(0), probes(0), rejects(0), fpr(0) {
+  nblocks = bytes / 64;
+  if (nblocks < 1) nblocks = 1;
+  bits.assign(nblocks * 8, 0);
+}
+
+unsigned long long pairfilter::hash(int key) {
+  unsigned long long h = key * 0x9e3779b97f4a7c15ULL;
+  h ^= h >> 31;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 29;
+  return h;
+}
+
+void pairfilter::insert(int key) {
+  unsigned long long h = hash(key);
+  unsigned long long *block = &bits[((h >> 36) % nblocks) * 8];
+  for (int k = 0; k < 4; k++) {
+    int b = (h >> (9*k)) & 511;
+    block[b >> 6] |= 1ULL << (b & 63);
+  }
+}
+
+bool pairfilter::contains(int key) {
+  unsigned long long h = hash(key);
+  unsigned long long *block = &bits[((h >> 36) % nblocks) * 8];
+  for (int k = 0; k < 4; k++) {
+    int b = (h >> (9*k)) & 511;
+    if ((block[b >> 6] & (1ULL << (b & 63))) == 0)
+      return false;
+  }
+  return true;
+}
+
+/**
+ * adds the letter pairs of every word of the files and measures the false positive
+ * rate exactly, over all pairs of the dictionary's letters that do
+ * not occur, for the word lengths present.
+ */
+
+void pairfilter::build(const vector<string> &files) {
+  vector<bool> present(pairkey(MAXWORDLEN, 0, 0, 0, 0), false);
+  bool lens[MAXWORDLEN];
+  for (int len = 0; len < MAXWORDLEN; len++) lens[len] = false;
+
+  for (unsigned f = 0; f < files.size(); f++) {
+    wordlist wl;
+    wl.load(files[f]);
+    alpha |= wl.allalpha;
+    for (int w = 0; w < wl.numwords(); w++) {
+      symbol *st = wl[w];
+      int len = wordlen(st);
+      if (len >= MAXWORDLEN) continue;
+      lens[len] = true;
+      for (int i = 0; i < len; i++)
+	for (int j = i+1; j < len; j++) {
+	  int key = pairkey(len, i, st[i].symbvalue(), j, st[j].symbvalue());
+	  if (present[key]) continue;
+	  present[key] = true;
+	  insert(key);
+	}
+    }
+  }
+
+  long absent = 0, falsepos = 0;
+  for (int len = 2; len < MAXWORDLEN; len++) {
+    if (!lens[len]) continue;
+    for (int i = 0; i < len; i++)
+      for (int j = i+1; j < len; j++)
+	for (int si = 0; si < MAXSYMBOLS; si++) {
+	  if (!hassym(alpha, si)) continue;
+	  for (int sj = 0; sj < MAXSYMBOLS; sj++) {
+	    if (!hassym(alpha, sj)) continue;
+	    int key = pairkey(len, i, si, j, sj);
+	    if (present[key]) continue;
+	    absent++;
+	    if (contains(key)) falsepos++;
+	  }
+	}
+  }
+  fpr = absent ? double(falsepos) / absent : 0;
+  cout << "Pair filter: " << memusage() / 1024 << " KB, "
+       << fpr * 100 << "% false positive rate" << endl;
+}
+
+/**
+ * removes from cand the letters at pos that never occur together with
+ * one of the known letters of the slot pattern s.
+ */
+
+symbolset pairfilter::bound(symbol *s, int len, int pos, symbolset cand) {
+  for (int i = 0; i < len && cand; i++) {
+    if (s[i] == symbol::empty) continue;
+    int si = s[i].symbvalue();
+    for (int x = 0; x < MAXSYMBOLS; x++) {
+      if (!hassym(cand, x)) continue;
+      int key = i < pos ? pairkey(len, i, si, pos, x)
+	: pairkey(len, pos, x, i, si);
+      if (!contains(key))
+	cand &= ~symbit(x);
+    }
+  }
+  return cand;
+}
+
+long pairfilter::memusage() {
+  return bits.capacity() * sizeof(unsigned long long);
+}
@@ -0,0 +1,59 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef PAIRFILTER_HH
+#define PAIRFILTER_HH
+
+#include <vector>
+#include "symbol.hh"
+
+/**
+ * pairfilter is a blocked Bloom filter over the (length, position,
+ * letter, position, letter) combinations that occur in the
+ * dictionary. Every key sets four bits within one 64 byte block, so a
+ * lookup touches a single cache line.
+ *
+ * Every slot pattern the solver builds has at least one matching
+ * word, so empty results come from crossing slots that disagree on
+ * the cell. cell::findpossible therefore asks the active filter for
+ * the letters at the cell that pair with every known letter of each
+ * slot, and rejects the cell without touching the dictionary when no
+ * letter survives for all slots.
+ */
+
+class pairfilter {
+  vector<unsigned long long> bits;
+  long nblocks;
+  static unsigned long long hash(int key);
+  void insert(int key);
+  bool contains(int key);
+  symbolset alpha;
+public:
+  long probes, rejects;
+  double fpr;                      // measured when built
+  pairfilter(long bytes);
+  void build(const vector<string> &files);
+  symbolset bound(symbol *s, int len, int pos, symbolset cand);
+  symbolset letters() { return alpha; }
+  long memusage();
+};
+
+extern pairfilter *activefilter;
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <unistd.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#endif
+
+#include "perfcount.hh"
+
+const char *perfcounters::names[NPERFCOUNTERS] = {
+  "cycles", "instructions", "cache_refs", "cache_misses", "branch_misses"
+};
+
+#ifdef __linux__
+
+/**
+ * counts the calling thread and the threads it starts later (the solve
+ * thread, -j workers, index build threads); a thread's counts are
+ * added when it exits, and all are joined before a phase ends.
+ */
+
+static int openevent(unsigned long long config) {
+  struct perf_event_attr pe;
+  memset(&pe, 0, sizeof(pe));
+  pe.type = PERF_TYPE_HARDWARE;
+  pe.size = sizeof(pe);
+  pe.config = config;
+  pe.exclude_kernel = 1;
+  pe.exclude_hv = 1;
+  pe.inherit = 1;
+  pe.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+    PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return syscall(__NR_perf_event_open, &pe, 0, -1, -1, 0);
+}
+
+perfcounters::perfcounters() {
+  static unsigned long long config[NPERFCOUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+  };
+  for (int i = 0; i < NPERFCOUNTERS; i++) {
+    fd[i] = openevent(config[i]);
+    base[i] = 0;
+  }
+}
+
+/**
+ * the kernel multiplexes counters when there are more events than
+ * hardware registers, so values are scaled by enabled/running time.
+ */
+
+void perfcounters::readraw(long long *v) {
+  for (int i = 0; i < NPERFCOUNTERS; i++) {
+    unsigned long long buf[3];
+    if ((fd[i] == -1) || (::read(fd[i], buf, sizeof(buf)) != sizeof(buf))) {
+      v[i] = -1;
+      continue;
+    }
+    if (buf[2] == 0)
+      v[i] = 0;
+    else
+      v[i] = (long long)(buf[0] * ((double)buf[1] / buf[2]));
+  }
+}
+
+#else
+
+perfcounters::perfcounters() {
+  for (int i = 0; i < NPERFCOUNTERS; i++) {
+    fd[i] = -1;
+    base[i] = 0;
+  }
+}
+
+void perfcounters::readraw(long long *v) {
+  for (int i = 0; i < NPERFCOUNTERS; i++)
+    v[i] = -1;
+}
+
+#endif
+
+perfcounters::~perfcounters() {
+  for (int i = 0; i < NPERFCOUNTERS; i++)
+    if (fd[i] != -1)
+      close(fd[i]);
+}
+
+void perfcounters::start() {
+  readraw(base);
+}
+
+void perfcounters::read(long long *v) {
+  readraw(v);
+  for (int i = 0; i < NPERFCOUNTERS; i++)
+    if (v[i] != -1)
+      v[i] -= base[i];
+}
@@ -0,0 +1,48 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef PERFCOUNT_HH
+#define PERFCOUNT_HH
+
+/**
+ * perfcounters reads the CPU's hardware performance counters through
+ * the Linux perf_event_open interface: cycles, instructions, cache
+ * references and misses, and branch misses of this process in user
+ * mode. Where the counters cannot be opened (other systems, containers,
+ * restrictive perf_event_paranoid settings) available() is false and
+ * all values read as -1, so callers need no special casing.
+ */
+
+#define NPERFCOUNTERS 5
+
+class perfcounters {
+  int fd[NPERFCOUNTERS];
+  long long base[NPERFCOUNTERS];
+  void readraw(long long *v);
+public:
+  static const char *names[NPERFCOUNTERS];
+  perfcounters();
+  ~perfcounters();
+  bool available() { return fd[0] != -1; }
+  void start();
+  // counts since start(), -1 where unavailable
+  void read(long long *v);
+};
+
+#endif
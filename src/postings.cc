@@ -0,0 +1,95 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <vector>
+
+#include "postings.hh"
+
+//////////////////////////////////////////////////////////////////////
+// packedlist
+
+void packedlist::pack(const vector<int> &v) {
+  n = v.size();
+  first.clear(); offset.clear(); bytes.clear();
+  int prev = 0;
+  for (int k = 0; k < n; k++) {
+    unsigned delta;
+    if (k % PACKEDBLOCK == 0) {
+      first.push_back(v[k]);
+      offset.push_back(bytes.size());
+      delta = 0;
+    } else
+      delta = v[k] - prev;
+    prev = v[k];
+    while (delta >= 0x80) {
+      bytes.push_back((delta & 0x7f) | 0x80);
+      delta >>= 7;
+    }
+    bytes.push_back(delta);
+  }
+}
+
+int packedlist::decode(int block, int *out) const {
+  int count = n - block * PACKEDBLOCK;
+  if (count > PACKEDBLOCK) count = PACKEDBLOCK;
+  const unsigned char *b = &bytes[offset[block]];
+  int val = first[block];
+  for (int k = 0; k < count; k++) {
+    unsigned delta = 0;
+    int shift = 0;
+    while (*b & 0x80) {
+      delta |= (*b++ & 0x7f) << shift;
+      shift += 7;
+    }
+    delta |= *b++ << shift;
+    val += delta;
+    out[k] = val;
+  }
+  return count;
+}
+
+long packedlist::memusage() const {
+  return sizeof(packedlist) + bytes.capacity()
+    + (first.capacity() + offset.capacity()) * sizeof(int);
+}
+
+//////////////////////////////////////////////////////////////////////
+// packedcursor
+
+void packedcursor::start(const packedlist *l) {
+  pl = l;
+  block = i = n = 0;
+  if (l->n) load(0);
+}
+
+void packedcursor::seek(int target) {
+  if (end() || buf[i] >= target) return;
+  if (buf[n-1] < target) {
+    // skip to the last block starting at or before target
+    int lo = block + 1, hi = pl->numblocks() - 1;
+    if (lo > hi) { i = n; return; }
+    while (lo < hi) {
+      int mid = (lo + hi + 1) / 2;
+      if (pl->first[mid] <= target) lo = mid; else hi = mid - 1;
+    }
+    load(lo);
+  }
+  while ((i < n) && (buf[i] < target)) i++;
+  if ((i == n) && (block + 1 < pl->numblocks())) load(block + 1);
+}
@@ -0,0 +1,66 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef POSTINGS_HH
+#define POSTINGS_HH
+
+#include <vector>
+
+#define PACKEDBLOCK 128
+
+/**
+ * A compressed posting list: sorted word numbers stored as varint
+ * coded deltas in blocks of PACKEDBLOCK postings. The first posting
+ * and byte offset of every block serve as skip pointers.
+ */
+
+struct packedlist {
+  int n;
+  vector<int> first;               // first posting of each block
+  vector<int> offset;              // byte offset of each block
+  vector<unsigned char> bytes;
+
+  packedlist() : n(0) {}
+  void pack(const vector<int> &v);
+  int numblocks() const { return first.size(); }
+  int decode(int block, int *out) const;
+  long memusage() const;
+};
+
+/**
+ * Walks a packedlist in order, decoding one block at a time as it is
+ * reached. seek uses the skip pointers to pass over whole blocks.
+ */
+
+class packedcursor {
+  const packedlist *pl;
+  int block, i, n;
+  int buf[PACKEDBLOCK];
+  void load(int b) { block = b; n = pl->decode(b, buf); i = 0; }
+public:
+  void start(const packedlist *l);
+  bool end() const { return i >= n; }
+  int value() const { return buf[i]; }
+  void next() {
+    if ((++i == n) && (block + 1 < pl->numblocks())) load(block + 1);
+  }
+  void seek(int target);
+};
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <iostream.h>
+#include <string>
+#include <vector>
+
+#include "main.hh"
+#include "timer.hh"
+#include "profile.hh"
+
+phaseprofiler profiler;
+
+phaseprofiler::phaseprofiler() : running(false), pc(0), enabled(false) {
+}
+
+phaseprofiler::~phaseprofiler() {
+  delete pc;
+}
+
+void phaseprofiler::sample(long long &wall, long long &usr, long long &sys) {
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  wall = hrtime();
+  usr = ru.ru_utime.tv_sec * 1000000LL + ru.ru_utime.tv_usec;
+  sys = ru.ru_stime.tv_sec * 1000000LL + ru.ru_stime.tv_usec;
+}
+
+void phaseprofiler::begin(const string &name) {
+  if (!enabled)
+    return;
+  end();
+  phase p;
+  p.name = name;
+  p.wallns = p.usrus = p.sysus = 0;
+  phases.push_back(p);
+  if (setup.perfcounters && pc == 0)
+    pc = new perfcounters();
+  if (pc)
+    pc->start();
+  sample(wall0, usr0, sys0);
+  running = true;
+}
+
+void phaseprofiler::end() {
+  if (!enabled || !running)
+    return;
+  long long wall, usr, sys;
+  sample(wall, usr, sys);
+  phase &p = phases.back();
+  p.wallns = wall - wall0;
+  p.usrus = usr - usr0;
+  p.sysus = sys - sys0;
+  if (pc)
+    pc->read(p.hw);
+  running = false;
+}
+
+void phaseprofiler::addmem(const string &name, long bytes) {
+  if (!enabled)
+    return;
+  memitem m;
+  m.name = name;
+  m.bytes = bytes;
+  mem.push_back(m);
+}
+
+void phaseprofiler::report(ostream &os) {
+  if (!enabled)
+    return;
+  end();
+  long long wall = 0, usr = 0, sys = 0;
+  os << "phase\twall_ms\tuser_ms\tsys_ms";
+  for (int i = 0; pc && i < NPERFCOUNTERS; i++)
+    os << '\t' << perfcounters::names[i];
+  os << endl;
+  for (unsigned i = 0; i < phases.size(); i++) {
+    phase &p = phases[i];
+    os << p.name << '\t' << p.wallns / 1e6 << '\t' << p.usrus / 1e3
+       << '\t' << p.sysus / 1e3;
+    for (int j = 0; pc && j < NPERFCOUNTERS; j++)
+      os << '\t' << p.hw[j];
+    os << endl;
+    wall += p.wallns; usr += p.usrus; sys += p.sysus;
+  }
+  os << "total\t" << wall / 1e6 << '\t' << usr / 1e3 << '\t' << sys / 1e3
+     << endl;
+
+  if (pc && !pc->available())
+    os << "hardware counters not available" << endl;
+
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  os << "peak RSS: " << ru.ru_maxrss << " kB" << endl;
+  for (unsigned i = 0; i < mem.size(); i++)
+    os << "memory " << mem[i].name << ": " << mem[i].bytes << " bytes"
+       << endl;
+}
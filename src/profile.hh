@@ -0,0 +1,65 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef PROFILE_HH
+#define PROFILE_HH
+
+#include <string>
+#include <vector>
+#include "perfcount.hh"
+
+/**
+ * The phase profiler splits a run into consecutive phases (load,
+ * index, grid, analysis, solve, output) and records monotonic wall
+ * time and user/system CPU time for each. Starting a phase ends the
+ * previous one. Modules also register the bytes held by their data
+ * structures, which are reported together with the peak RSS. With
+ * -H each phase also gets hardware counter totals. When profiling is
+ * off (no -P) all calls return immediately.
+ */
+
+class phaseprofiler {
+  struct phase {
+    string name;
+    long long wallns, usrus, sysus;
+    long long hw[NPERFCOUNTERS];
+  };
+  struct memitem {
+    string name;
+    long bytes;
+  };
+  vector<phase> phases;
+  vector<memitem> mem;
+  bool running;
+  long long wall0, usr0, sys0;
+  perfcounters *pc;
+  void sample(long long &wall, long long &usr, long long &sys);
+public:
+  bool enabled;
+  phaseprofiler();
+  ~phaseprofiler();
+  void begin(const string &name);
+  void end();
+  void addmem(const string &name, long bytes);
+  void report(ostream &os);
+};
+
+extern phaseprofiler profiler;
+
+#endif
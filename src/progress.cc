@@ -0,0 +1,62 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "progress.hh"
+
+volatile sig_atomic_t searchevents = 0;
+
+static void statshandler(int) {
+  __sync_fetch_and_or(&searchevents, STATS_EVENT);
+}
+
+static void progresshandler(int) {
+  __sync_fetch_and_or(&searchevents, PROGRESS_EVENT);
+}
+
+static void installhandler(int sig, void (*handler)(int)) {
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = handler;
+  sa.sa_flags = SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+  sigaction(sig, &sa, 0);
+}
+
+void installstatshandler() {
+  installhandler(SIGUSR1, statshandler);
+}
+
+void startprogresstimer(int msecs) {
+  installhandler(SIGALRM, progresshandler);
+  struct itimerval it;
+  it.it_interval.tv_sec = msecs / 1000;
+  it.it_interval.tv_usec = (msecs % 1000) * 1000;
+  it.it_value = it.it_interval;
+  setitimer(ITIMER_REAL, &it, 0);
+}
+
+void stopprogresstimer() {
+  struct itimerval it;
+  memset(&it, 0, sizeof(it));
+  setitimer(ITIMER_REAL, &it, 0);
+}
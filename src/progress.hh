@@ -0,0 +1,42 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef PROGRESS_HH
+#define PROGRESS_HH
+
+#include <signal.h>
+
+/**
+ * Asynchronous events for the search. Signal handlers only set bits
+ * in searchevents; the search loop tests the word once per node and
+ * handles the events at a point where the grid is consistent. Progress
+ * is driven by an interval timer (SIGALRM), statistics dumps by
+ * SIGUSR1.
+ */
+
+#define STATS_EVENT 1
+#define PROGRESS_EVENT 2
+
+extern volatile sig_atomic_t searchevents;
+
+void installstatshandler();
+void startprogresstimer(int msecs);
+void stopprogresstimer();
+
+#endif
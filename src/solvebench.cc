@@ -0,0 +1,216 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <stdlib.h>
+#include <iostream.h>
+#include <fstream.h>
+#include <strstream>
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <algo.h>
+
+#include "timer.hh"
+#include "symbol.hh"
+#include "dict.hh"
+#include "engines.hh"
+#include "grid.hh"
+#include "cwc.hh"
+#include "dictbench.hh"
+#include "solvebench.hh"
+
+struct corpusentry {
+  char format;
+  string file, name;
+};
+
+static void readcorpus(const string &fn, vector<corpusentry> &corpus) {
+  ifstream f(fn.c_str());
+  if (!f.is_open()) throw error("Failed to open corpus file");
+  string::size_type slash = fn.rfind('/');
+  string dir = (slash == string::npos) ? string("") : fn.substr(0, slash+1);
+
+  string ln;
+  while (getline(f, ln)) {
+    if (ln.empty() || ln[0] == '#')
+      continue;
+    istrstream is(ln.c_str());
+    corpusentry e;
+    if (!(is >> e.format >> e.name) || (e.format != 'p' && e.format != 'g'))
+      throw error("Invalid corpus line: " + ln);
+    e.file = dir + e.name;
+    corpus.push_back(e);
+  }
+}
+
+struct runsummary {
+  int runs, solved;
+  double median_ms, p90_ms, max_ms;
+  long median_nodes, max_nodes, median_backtracks;
+};
+
+template<class T>
+static T pick(vector<T> &v, double p) {
+  sort(v.begin(), v.end());
+  unsigned i = (unsigned)(p * v.size());
+  if (i >= v.size()) i = v.size() - 1;
+  return v[i];
+}
+
+static runsummary runall(corpusentry &e, setup_s::walker_t wt, dict &d,
+			 benchparams &bp) {
+  vector<double> ms;
+  vector<long> nodes, bts;
+  runsummary s;
+  s.runs = s.solved = 0;
+
+  for (int seed = 1; seed <= bp.seeds; seed++) {
+    grid g;
+    if (e.format == 'g')
+      g.load(e.file);
+    else
+      g.load_template(e.file);
+
+    walker *w = newwalker(wt, g);
+    smart_backtracker bt(g);
+    compiler c(g, *w, bt, d);
+    c.nodelimit = bp.nodelimit;
+
+    srand(seed);
+    long long t0 = hrtime();
+    bool ok = c.compile() && !c.wasaborted();
+    ms.push_back((hrtime() - t0) / 1e6);
+    nodes.push_back(c.stats.nodes);
+    bts.push_back(c.stats.backtracks);
+    s.runs++;
+    if (ok) s.solved++;
+    delete w;
+  }
+  s.median_ms = pick(ms, 0.5);
+  s.p90_ms = pick(ms, 0.9);
+  s.max_ms = pick(ms, 1.0);
+  s.median_nodes = pick(nodes, 0.5);
+  s.max_nodes = pick(nodes, 1.0);
+  s.median_backtracks = pick(bts, 0.5);
+  return s;
+}
+
+static const char header[] =
+  "grid\twalker\tengine\truns\tsolved\tmedian_ms\tp90_ms\tmax_ms"
+  "\tmedian_nodes\tmax_nodes\tmedian_backtracks";
+
+static void writesummary(ostream &os, const string &key, runsummary &s) {
+  os << key << '\t' << s.runs << '\t' << s.solved << '\t'
+     << s.median_ms << '\t' << s.p90_ms << '\t' << s.max_ms << '\t'
+     << s.median_nodes << '\t' << s.max_nodes << '\t'
+     << s.median_backtracks << endl;
+}
+
+static void readsummary(const string &fn, map<string, runsummary> &m) {
+  ifstream f(fn.c_str());
+  if (!f.is_open()) throw error("Failed to open baseline file");
+  string ln;
+  while (getline(f, ln)) {
+    if (ln.empty() || ln[0] == '#' || ln.compare(0, 5, "grid\t") == 0)
+      continue;
+    istrstream is(ln.c_str());
+    string gname, wname, ename;
+    runsummary s;
+    if (is >> gname >> wname >> ename >> s.runs >> s.solved >> s.median_ms
+	>> s.p90_ms >> s.max_ms >> s.median_nodes >> s.max_nodes
+	>> s.median_backtracks)
+      m[gname + '\t' + wname + '\t' + ename] = s;
+  }
+}
+
+/**
+ * compares a result with its baseline. Times below one millisecond
+ * are considered noise.
+ */
+
+static int compare(const string &key, runsummary &cur, runsummary &base,
+		   int tolerance) {
+  int regressions = 0;
+  if (cur.solved < base.solved) {
+    cout << "REGRESSION " << key << ": solved " << cur.solved
+	 << " of " << cur.runs << ", baseline " << base.solved << endl;
+    regressions++;
+  }
+  if ((cur.median_ms > base.median_ms * (1 + tolerance/100.0)) &&
+      (cur.median_ms - base.median_ms > 1.0)) {
+    cout << "REGRESSION " << key << ": median " << cur.median_ms
+	 << " ms, baseline " << base.median_ms << " ms" << endl;
+    regressions++;
+  }
+  if (cur.median_nodes != base.median_nodes)
+    cout << "changed " << key << ": median nodes " << cur.median_nodes
+	 << ", baseline " << base.median_nodes << endl;
+  return regressions;
+}
+
+int dosolvebench(const string &corpusfile) {
+  benchparams bp;
+  bp.parse(setup.benchopts);
+
+  vector<corpusentry> corpus;
+  readcorpus(corpusfile, corpus);
+
+  int nengines = numdictengines();
+  vector<dict*> dicts(nengines);
+  for (int e = 0; e < nengines; e++) {
+    dicts[e] = dictengines[e].create();
+    dicts[e]->load(setup.dictfile);
+  }
+
+  map<string, runsummary> baseline;
+  if (!bp.baseline.empty())
+    readsummary(bp.baseline, baseline);
+
+  ofstream of;
+  if (!bp.out.empty()) {
+    of.open(bp.out.c_str());
+    if (!of.is_open()) throw error("Failed to open benchmark output");
+    of << "# dictionary=" << setup.dictfile << " seeds=" << bp.seeds
+       << " nodelimit=" << bp.nodelimit << endl << header << endl;
+  }
+  cout << header << endl;
+
+  int regressions = 0;
+  for (unsigned i = 0; i < corpus.size(); i++) {
+    for (int wt = 0; walkernames[wt]; wt++) {
+      for (int e = 0; e < nengines; e++) {
+	runsummary s = runall(corpus[i], setup_s::walker_t(wt), *dicts[e], bp);
+	string key = corpus[i].name + '\t' + walkernames[wt] + '\t'
+	  + dictengines[e].name;
+	writesummary(cout, key, s);
+	if (of.is_open())
+	  writesummary(of, key, s);
+	if (baseline.count(key))
+	  regressions += compare(key, s, baseline[key], bp.tolerance);
+      }
+    }
+  }
+
+  for (int e = 0; e < nengines; e++)
+    delete dicts[e];
+  if (!bp.baseline.empty())
+    cout << regressions << " regressions against " << bp.baseline << endl;
+  return regressions;
+}
@@ -0,0 +1,35 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef SOLVEBENCH_HH
+#define SOLVEBENCH_HH
+
+#include <string>
+
+/**
+ * The solver benchmark runs every grid of a corpus file with a fixed
+ * set of seeds under every walker and dictionary engine, and reports
+ * median and tail solve times, nodes and backtracks. The summary table
+ * can be saved (out=) and given as baseline= to a later build, which
+ * then reports regressions. Returns the number of regressions found.
+ */
+
+int dosolvebench(const string &corpusfile);
+
+#endif
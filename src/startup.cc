@@ -0,0 +1,213 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <fstream.h>
+
+#include "gridscope.hh"
+#include "engines.hh"
+#include "startup.hh"
+
+#define BATCHWORDS 4096
+#define MAXBATCHES 16
+
+void loadgrid(grid &g) {
+  if (setup.gridformat == setup.generalgrid)
+    g.load(setup.gridfile);
+  else if (setup.gridformat == setup.squaregrid)
+    g.load_template(setup.gridfile);
+}
+
+//////////////////////////////////////////////////////////////////////
+// struct gridanalysis
+
+void gridanalysis::run(grid &g) {
+  interlock = g.interlockdegree();
+  depdeg1 = depdeg2 = 0;
+  if (setup.depsample != 0) {
+    depdeg1 = g.depencydegree(1, setup.threads, setup.depsample);
+    depdeg2 = g.depencydegree(2, setup.threads, setup.depsample);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+// class startup
+
+startup::startup(dict *d, grid &g)
+  : d(d), g(g), readdone(false), gridready(false), stopped(false),
+    wordcount(0), wordsused(0) {
+  pthread_mutex_init(&lock, 0);
+  pthread_cond_init(&changed, 0);
+}
+
+startup::~startup() {
+  for (list<vector<string>*>::iterator i = batches.begin();
+       i != batches.end(); i++)
+    delete *i;
+  pthread_cond_destroy(&changed);
+  pthread_mutex_destroy(&lock);
+}
+
+// queues a batch for the indexer; false if the indexer has stopped
+bool startup::push(vector<string> *batch) {
+  pthread_mutex_lock(&lock);
+  while (!stopped && batches.size() >= MAXBATCHES)
+    pthread_cond_wait(&changed, &lock);
+  bool ok = !stopped;
+  if (ok)
+    batches.push_back(batch);
+  else
+    delete batch;
+  pthread_cond_broadcast(&changed);
+  pthread_mutex_unlock(&lock);
+  return ok;
+}
+
+// the next batch to index, 0 when the file is read
+vector<string> *startup::nextbatch() {
+  pthread_mutex_lock(&lock);
+  while (batches.empty() && !readdone)
+    pthread_cond_wait(&changed, &lock);
+  vector<string> *batch = 0;
+  if (!batches.empty()) {
+    batch = batches.front();
+    batches.pop_front();
+  }
+  pthread_cond_broadcast(&changed);
+  pthread_mutex_unlock(&lock);
+  return batch;
+}
+
+void startup::read() {
+  ifstream f(dictfile.c_str());
+  if (!f.is_open()) throw error("Failed to open dictionary file");
+
+  if (dictopts.prune) {
+    pthread_mutex_lock(&lock);
+    while (!gridready)
+      pthread_cond_wait(&changed, &lock);
+    bool failed = !griderror.empty();
+    pthread_mutex_unlock(&lock);
+    if (failed) return;
+  }
+
+  vector<string> *batch = new vector<string>;
+  string ln;
+  while (!f.eof()) {
+    getline(f, ln);
+    int wlen = ln.length();
+    if (wlen == 0) continue;
+    wordcount++;
+    bool ok = true;
+    for (int i = 0; i < wlen; i++) {
+      ln[i] = tolower(ln[i]);
+      if (!wordchar(ln[i]))
+	ok = false;
+    }
+    if (!ok || (activescope && !activescope->allows(ln)))
+      continue;
+    wordsused++;
+    batch->push_back(ln);
+    if (batch->size() == BATCHWORDS) {
+      if (!push(batch)) return;
+      batch = new vector<string>;
+    }
+  }
+  push(batch);
+}
+
+void *startup::reader(void *arg) {
+  startup *s = (startup*)arg;
+  try {
+    s->read();
+  } catch (error e) {
+    s->readerror = e.what();
+  }
+  pthread_mutex_lock(&s->lock);
+  s->readdone = true;
+  pthread_cond_broadcast(&s->changed);
+  pthread_mutex_unlock(&s->lock);
+  return 0;
+}
+
+void *startup::gridder(void *arg) {
+  startup *s = (startup*)arg;
+  string err;
+  try {
+    loadgrid(s->g);
+    if (dictopts.prune)
+      activescope = new gridscope(s->g);
+  } catch (error e) {
+    err = e.what();
+  }
+  pthread_mutex_lock(&s->lock);
+  s->griderror = err;
+  s->gridready = true;
+  pthread_cond_broadcast(&s->changed);
+  pthread_mutex_unlock(&s->lock);
+  if (err.empty()) {
+    try {
+      s->analysis.run(s->g);
+    } catch (error e) {
+      s->griderror = e.what();
+    }
+  }
+  return 0;
+}
+
+/**
+ * loads the dictionary into d and the grid into g, returning when
+ * both are done. Errors of either thread are thrown here.
+ */
+
+void startup::run(const string &fn) {
+  dictfile = fn;
+  if (!dictopts.prune)
+    symbol::hold();
+  pthread_t rtid, gtid;
+  if (pthread_create(&gtid, 0, gridder, this))
+    throw error("Failed to start grid thread");
+  if (pthread_create(&rtid, 0, reader, this)) {
+    symbol::release();
+    pthread_join(gtid, 0);
+    throw error("Failed to start dictionary thread");
+  }
+
+  string indexerror;
+  try {
+    while (vector<string> *batch = nextbatch()) {
+      d->addwords(*batch);
+      delete batch;
+    }
+    if (readerror.empty())
+      d->finishwords();
+  } catch (error e) {
+    indexerror = e.what();
+    pthread_mutex_lock(&lock);
+    stopped = true;
+    pthread_cond_broadcast(&changed);
+    pthread_mutex_unlock(&lock);
+  }
+  symbol::release();
+  pthread_join(rtid, 0);
+  pthread_join(gtid, 0);
+
+  if (!readerror.empty()) throw error(readerror);
+  if (!indexerror.empty()) throw error(indexerror);
+  if (!griderror.empty()) throw error(griderror);
+}
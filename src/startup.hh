@@ -0,0 +1,76 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef STARTUP_HH
+#define STARTUP_HH
+
+#include <pthread.h>
+#include <list>
+#include <vector>
+#include "symbol.hh"
+#include "dict.hh"
+#include "grid.hh"
+
+// loads the -p or -g grid
+void loadgrid(grid &g);
+
+// the grid statistics printed before the search
+struct gridanalysis {
+  float interlock;
+  double depdeg1, depdeg2;     // not computed with -a 0
+  void run(grid &g);
+};
+
+/**
+ * startup loads the dictionary and the grid at the same time (-L). A
+ * reader thread reads and tokenizes the dictionary file and queues
+ * batches of words; the calling thread adds each batch to the index
+ * as it arrives (dict::addwords) and builds the index when the file
+ * is read (dict::finishwords). Meanwhile a grid thread loads the grid
+ * and runs the analysis.
+ *
+ * Symbols are held while the dictionary is read (symbol::hold), so
+ * the letters of a template get the same numbers as when the grid is
+ * loaded after the dictionary, and a seed gives the same solution.
+ * With -D prune=1 the reader waits for the grid instead.
+ */
+
+class startup {
+  dict *d;
+  grid &g;
+  string dictfile;
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+  list<vector<string>*> batches;   // read, not yet indexed
+  bool readdone, gridready, stopped;
+  string readerror, griderror;
+  static void *reader(void *);
+  static void *gridder(void *);
+  void read();
+  bool push(vector<string> *batch);
+  vector<string> *nextbatch();
+public:
+  long wordcount, wordsused;
+  gridanalysis analysis;
+  startup(dict *d, grid &g);
+  ~startup();
+  void run(const string &dictfile);
+};
+
+#endif
@@ -0,0 +1,112 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <iostream.h>
+#include <vector>
+#include <algo.h>
+
+#include "stats.hh"
+
+//////////////////////////////////////////////////////////////////////
+// searchstats
+
+searchstats::searchstats() : engine("") {
+  reset();
+}
+
+/**
+ * clears the counts. The dead ends are kept by cell, only for the
+ * cells that had one, so a search of a small part of a large grid
+ * costs nothing per grid cell.
+ */
+
+void searchstats::reset() {
+  nodes = backtracks = 0;
+  findpossible = 0;
+  dictns = 0;
+  maxdepth = 0;
+  for (int i = 0; i < BACKJUMPBUCKETS; i++)
+    backjump[i] = 0;
+  deadends.clear();
+}
+
+void searchstats::merge(const searchstats &o) {
+  nodes += o.nodes;
+  backtracks += o.backtracks;
+  findpossible += o.findpossible;
+  dictns += o.dictns;
+  if (o.maxdepth > maxdepth)
+    maxdepth = o.maxdepth;
+  for (int i = 0; i < BACKJUMPBUCKETS; i++)
+    backjump[i] += o.backjump[i];
+  for (map<int, long>::const_iterator i = o.deadends.begin();
+       i != o.deadends.end(); i++)
+    deadends[i->first] += i->second;
+}
+
+// cells with most dead ends first
+struct deadend_order {
+  map<int, long> *d;
+  bool operator()(int a, int b) const { return (*d)[a] > (*d)[b]; }
+};
+
+void searchstats::dump(ostream &os, bool json) {
+  vector<int> cells;
+  for (map<int, long>::iterator i = deadends.begin(); i != deadends.end(); i++)
+    cells.push_back(i->first);
+  deadend_order order = { &deadends };
+  sort(cells.begin(), cells.end(), order);
+
+  if (json) {
+    os << "{\"nodes\":" << nodes << ",\"backtracks\":" << backtracks
+       << ",\"engine\":\"" << engine << "\",\"max_depth\":" << maxdepth;
+#ifdef CWC_STATS
+    os << ",\"findpossible\":" << findpossible
+       << ",\"dict_ms\":" << dictns / 1e6 << ",\"backjump\":[";
+    for (int i = 0; i < BACKJUMPBUCKETS; i++)
+      os << (i ? "," : "") << backjump[i];
+    os << "],\"deadends\":{";
+    for (unsigned i = 0; i < cells.size(); i++)
+      os << (i ? "," : "") << '"' << cells[i] << "\":" << deadends[cells[i]];
+    os << "}}" << endl;
+#else
+    // only counted in a CWC_STATS build
+    os << ",\"findpossible\":null,\"dict_ms\":null,\"backjump\":null"
+       << ",\"deadends\":null}" << endl;
+#endif
+    return;
+  }
+
+  os << "nodes: " << nodes << endl;
+  os << "backtracks: " << backtracks << endl;
+  os << "max depth: " << maxdepth << endl;
+#ifdef CWC_STATS
+  os << "findpossible calls (" << engine << "): " << findpossible << endl;
+  os << "dictionary time: " << dictns / 1000000 << " msecs" << endl;
+  os << "backjump distance:";
+  for (int i = 1; i < BACKJUMPBUCKETS; i++)
+    if (backjump[i])
+      os << ' ' << i << (i == BACKJUMPBUCKETS-1 ? "+:" : ":") << backjump[i];
+  os << endl;
+  os << "dead ends by cell:";
+  for (unsigned i = 0; i < cells.size() && i < 10; i++)
+    os << ' ' << cells[i] << ':' << deadends[cells[i]];
+  os << endl;
+#endif
+}
@@ -0,0 +1,57 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef STATS_HH
+#define STATS_HH
+
+#include <vector>
+#include <map>
+#include "main.hh"
+
+/**
+ * Search statistics. Nodes, backtracks and the maximum depth are
+ * always counted; the remaining counters are only maintained when cwc is built with
+ * -DCWC_STATS (see Makefile), otherwise STAT() expands to nothing
+ * and the search loop carries no extra cost.
+ */
+
+#ifdef CWC_STATS
+#define STAT(x) x
+#else
+#define STAT(x)
+#endif
+
+#define BACKJUMPBUCKETS 16
+
+struct searchstats {
+  long nodes, backtracks;
+  int maxdepth;
+  const char *engine;
+  long findpossible;               // dictionary queries
+  long long dictns;                // time spent in cell::findpossible
+  long backjump[BACKJUMPBUCKETS];  // backjump distance, last = more
+  map<int, long> deadends;         // dead ends by cell number
+
+  searchstats();
+  void reset();
+  void merge(const searchstats &o);  // add the counts of another search
+  void dump(ostream &os, bool json);
+} __attribute__ ((aligned (64)));
+
+#endif
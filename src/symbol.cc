@@ -17,6 +17,7 @@
  * 02111-1307, USA. 
  **/
 
+#include <pthread.h>
 #include <iostream.h>
 
 #include "symbol.hh"
@@ -24,7 +25,7 @@
 //////////////////////////////////////////////////////////////////////
 // class symbol
 
-char symbol::alphabet[32];
+char symbol::alphabet[MAXSYMBOLS];
 symbol symbol::alphindex[256];
 
 int symbol::symballoc = 0;
@@ -32,20 +33,24 @@ symbol symbol::outside;
 symbol symbol::none;
 symbol symbol::empty;
 
+static pthread_mutex_t alloclock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t allocated = PTHREAD_COND_INITIALIZER;
+static bool held = false;
+
 symbol symbol::symbolbit(symbolset ss) {
   symbol s;
-  for (symbolset i=1,n=0; i; i<<=1,n++) {
-    if (ss&i)
-      s.symb = n;
-  }
-  return s;      
+  if (ss)
+    s.symb = lowestsym(ss);
+  return s;
 }
 
 symbol symbol::alloc(char ch) {
   symbol s;
-  if (symballoc >= 32) {
-    for (int i=0; i<32;i++) cout << alphabet[i]; cout << endl;
+  if (symballoc >= MAXSYMBOLS) {
+    for (int i=0; i<MAXSYMBOLS;i++) cout << alphabet[i]; cout << endl;
     cout << ch << ' ' << int(ch) << endl;
+    cout << "symbol sets are " << SYMBOLBITS << " bits wide, rebuild with "
+	 << "a larger SYMBOLBITS (64 or 128)" << endl;
     throw error("Too many symbols");
   }
 
@@ -57,7 +62,7 @@ symbol symbol::alloc(char ch) {
 }
 
 void symbol::buildindex() {
-  for (int i=0;i<32;i++)
+  for (int i=0;i<MAXSYMBOLS;i++)
     alphabet[i] = UNDEF;
   for (int i=0;i<256;i++)
     alphindex[i].symb = UNDEF;
@@ -69,28 +74,97 @@ void symbol::buildindex() {
 
 symbol::symbol(char ch) {
   symb = alphindex[(unsigned char)ch].symb;
-  if (symb == UNDEF)
-    *this = symbol::alloc(ch);
+  if (symb != UNDEF)
+    return;
+  pthread_mutex_lock(&alloclock);
+  symb = alphindex[(unsigned char)ch].symb;
+  try {
+    if (symb == UNDEF)
+      *this = symbol::alloc(ch);
+  } catch (error e) {
+    pthread_mutex_unlock(&alloclock);
+    throw;
+  }
+  pthread_cond_broadcast(&allocated);
+  pthread_mutex_unlock(&alloclock);
+}
+
+void symbol::hold() {
+  pthread_mutex_lock(&alloclock);
+  held = true;
+  pthread_mutex_unlock(&alloclock);
+}
+
+void symbol::release() {
+  pthread_mutex_lock(&alloclock);
+  held = false;
+  pthread_cond_broadcast(&allocated);
+  pthread_mutex_unlock(&alloclock);
+}
+
+symbol symbol::await(char ch) {
+  pthread_mutex_lock(&alloclock);
+  while (held && alphindex[(unsigned char)ch].symb == UNDEF)
+    pthread_cond_wait(&allocated, &alloclock);
+  pthread_mutex_unlock(&alloclock);
+  return symbol(ch);
+}
+
+// rand_r state of the calling thread's picks, or 0 to use rand()
+static __thread unsigned *pickstate = 0;
+
+/**
+ * makes the calling thread's picks draw from state, so a part solved
+ * on a -j worker takes the same choices whichever thread runs it.
+ */
+
+void pickseed(unsigned *state) {
+  pickstate = state;
 }
 
+/**
+ * removes and returns a random bit of ss; the k'th lowest for a
+ * random k, so the choice is the same at every width.
+ */
+
 symbolset pickbit(symbolset &ss) {
-  int a[32], n = 0;
-  for (int i=1; i; i<<=1) {
-    if (ss & i)
-      a[n++] = i;
-  }
+  int n = popcount(ss);
   if (n==0) return 0;
-  symbolset bit = a[rand()%n];
+  symbolset rest = ss;
+  int r = pickstate ? rand_r(pickstate) : rand();
+  for (int k = r%n; k > 0; k--)
+    rest &= ~symbit(lowestsym(rest));
+  symbolset bit = symbit(lowestsym(rest));
   ss &= ~bit;
   return bit;
 }
 
+/**
+ * true for characters words may have: letters, and with wide symbol
+ * sets also digits and 8 bit characters (accented latin-1 letters).
+ */
+
+bool wordchar(char ch) {
+  unsigned char c = ch;
+  if (isalpha(c))
+    return true;
+  return SYMBOLBITS > 32 && (isdigit(c) || c >= 0x80);
+}
+
 int wordlen(symbol *st) {
   int n = 0;
   while (st[n] != symbol::outside) n++;
   return n;
 }
 
+// true if word has the letters of the pattern at its known positions
+bool wordmatches(symbol *word, symbol *pattern, int len) {
+  for (int i = 0; i < len; i++)
+    if ((pattern[i] != symbol::empty) && (word[i] != pattern[i]))
+      return false;
+  return true;
+}
+
 ostream &operator <<(ostream &os, symbol *s) {
   while (*s != symbol::outside) {
     os << *s;
@@ -99,19 +173,10 @@ ostream &operator <<(ostream &os, symbol *s) {
   return os;
 }
 
-int numones(symbolset ss) {
-  int n = 0;
-  for (int i=1; i; i <<= 1) {
-    if (ss&i)
-      n++;
-  }
-  return n;
-}
-
 int symbol::numalpha() {
   int n = 0;
-  for (int i=0; i<32; i++)
-    if (isalpha(alphabet[i]))
+  for (int i=0; i<MAXSYMBOLS; i++)
+    if (wordchar(alphabet[i]))
       n++;
   return n;
 }
@@ -22,9 +22,118 @@
 
 #include "main.hh"
 
-typedef unsigned long symbolset;
+/**
+ * A symbolset has one bit per symbol. Its width is fixed at compile
+ * time with SYMBOLBITS (32, 64 or 128, see SYMBOLS in the Makefile);
+ * three symbols go to the none, empty and outside sentinels. Up to 64
+ * bits a set is a plain integer, so the default build is unchanged.
+ * Wider sets are a wideset, which has the integer operators the
+ * solver uses; code that needs a single bit or a bit count goes
+ * through symbit, hassym, lowestsym and popcount below, which exist
+ * once per representation.
+ */
+
+#ifndef SYMBOLBITS
+#define SYMBOLBITS 32
+#endif
+
+template<int BITS> class wideset {
+public:
+  enum { WORDS = BITS / 64 };
+  unsigned long long w[WORDS];
+
+  wideset() {}
+  wideset(long v) {
+    w[0] = v;
+    for (int i = 1; i < WORDS; i++) w[i] = v < 0 ? ~0ULL : 0;
+  }
+  static wideset bit(int n) {
+    wideset r(0);
+    r.w[n >> 6] = 1ULL << (n & 63);
+    return r;
+  }
+  bool test(int n) const { return (w[n >> 6] >> (n & 63)) & 1; }
+
+  wideset &operator &=(const wideset &o) {
+    for (int i = 0; i < WORDS; i++) w[i] &= o.w[i];
+    return *this;
+  }
+  wideset &operator |=(const wideset &o) {
+    for (int i = 0; i < WORDS; i++) w[i] |= o.w[i];
+    return *this;
+  }
+  wideset &operator ^=(const wideset &o) {
+    for (int i = 0; i < WORDS; i++) w[i] ^= o.w[i];
+    return *this;
+  }
+  wideset operator &(const wideset &o) const { wideset r(*this); return r &= o; }
+  wideset operator |(const wideset &o) const { wideset r(*this); return r |= o; }
+  wideset operator ^(const wideset &o) const { wideset r(*this); return r ^= o; }
+  wideset operator ~() const {
+    wideset r;
+    for (int i = 0; i < WORDS; i++) r.w[i] = ~w[i];
+    return r;
+  }
+  bool operator ==(const wideset &o) const {
+    for (int i = 0; i < WORDS; i++)
+      if (w[i] != o.w[i]) return false;
+    return true;
+  }
+  bool operator !=(const wideset &o) const { return !(*this == o); }
+  bool operator ==(int v) const { return *this == wideset(v); }
+  bool operator !=(int v) const { return !(*this == wideset(v)); }
+  bool operator !() const { return *this == 0; }
+
+  // usable in conditions, but not as an integer
+  typedef void (wideset::*boolean)() const;
+  void istrue() const {}
+  operator boolean() const { return !*this ? 0 : &wideset::istrue; }
+};
 
+template<int BITS> struct symbolsetrep { typedef wideset<BITS> type; };
+template<> struct symbolsetrep<32> { typedef unsigned long type; };
+template<> struct symbolsetrep<64> { typedef unsigned long long type; };
+
+typedef symbolsetrep<SYMBOLBITS>::type symbolset;
+
+// UNDEF is not a symbol, so a 128 bit build has 127
 #define UNDEF 0x7f
+#define MAXSYMBOLS (SYMBOLBITS < UNDEF ? SYMBOLBITS : UNDEF)
+
+inline int popcount(unsigned long ss) { return __builtin_popcountl(ss); }
+inline int popcount(unsigned long long ss) { return __builtin_popcountll(ss); }
+template<int BITS> inline int popcount(const wideset<BITS> &ss) {
+  int n = 0;
+  for (int i = 0; i < wideset<BITS>::WORDS; i++)
+    n += __builtin_popcountll(ss.w[i]);
+  return n;
+}
+
+// number of the lowest symbol in a non-empty set
+inline int lowestsym(unsigned long ss) { return __builtin_ctzl(ss); }
+inline int lowestsym(unsigned long long ss) { return __builtin_ctzll(ss); }
+template<int BITS> inline int lowestsym(const wideset<BITS> &ss) {
+  int i = 0;
+  while (ss.w[i] == 0) i++;
+  return i*64 + __builtin_ctzll(ss.w[i]);
+}
+
+// the set holding only symbol number n
+inline symbolset symbit(int n) {
+#if SYMBOLBITS <= 64
+  return symbolset(1) << n;
+#else
+  return symbolset::bit(n);
+#endif
+}
+
+inline bool hassym(const symbolset &ss, int n) {
+#if SYMBOLBITS <= 64
+  return (ss >> n) & 1;
+#else
+  return ss.test(n);
+#endif
+}
 
 class symbol {
   char symb;
@@ -32,7 +141,7 @@ class symbol {
   static char searchchar(char);
   static int symballoc;
 public:
-  static char alphabet[32];
+  static char alphabet[MAXSYMBOLS];
   static symbol outside, empty, none; 
   static symbol alloc(char ch = UNDEF);
   static symbol symbolbit(symbolset); // named constructor
@@ -46,12 +155,17 @@ public:
   inline bool operator == (symbol const &s) const;
 
   static void buildindex();
+  // while held, await waits until the dictionary has allocated ch, so
+  // a grid loaded alongside it numbers its letters the same way
+  static void hold();
+  static void release();
+  static symbol await(char ch);
   int symbvalue() { return int(symb); }
   static int numalpha();
 };
 
 symbolset symbol::getsymbolset() {
-  return 1 << symb;
+  return symbit(symb);
 }
 
 bool symbol::operator==(symbol const &s) const {
@@ -64,6 +178,11 @@ symbol::operator char() {
 }
 
 symbolset pickbit(symbolset &ss);
+void pickseed(unsigned *state);
+
+inline int numones(symbolset ss) {
+  return popcount(ss);
+}
 
 //////////////////////////////////////////////////////////////////////
 
@@ -71,9 +190,9 @@ void dumpset(symbolset ss);
 void dumpsymbollist(symbol *s, int n);
 ostream &operator <<(ostream &os, symbol *s);
 
+bool wordchar(char ch);
 int wordlen(symbol *st);
-
-int numones(symbolset ss);
+bool wordmatches(symbol *word, symbol *pattern, int len);
 
 #endif
 
@@ -61,4 +61,8 @@ int timer::getmsecs() {
   return (getticks() * 1000) / CLK_TCK;
 }
 
-
+long long hrtime() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
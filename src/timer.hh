@@ -17,6 +17,9 @@
  * 02111-1307, USA. 
  **/
 
+#ifndef TIMER_HH
+#define TIMER_HH
+
 #include <sys/times.h>
 
 /**
@@ -37,3 +40,13 @@ public:
   void reset();
   int getmsecs();
 };
+
+/**
+ * hrtime() reads the monotonic wall clock in nanoseconds. Use it
+ * where the tick resolution of timer is too coarse, e.g. when timing
+ * single dictionary queries.
+ */
+
+long long hrtime();
+
+#endif
@@ -0,0 +1,195 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <stdio.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+#include "symbol.hh"
+#include "trace.hh"
+
+tracer *activetracer = 0;
+
+static __thread tracer *ownertracer = 0;
+static __thread tracebuffer *ownbuffer = 0;
+
+tracebuffer *tracebuf() {
+  if (activetracer == 0)
+    return 0;
+  if (ownertracer != activetracer) {
+    ownbuffer = activetracer->buffer();
+    ownertracer = activetracer;
+  }
+  return ownbuffer;
+}
+
+unsigned int patternsignature(symbol *s, int len) {
+  unsigned int h = 2166136261u;
+  for (int i = 0; i < len; i++)
+    h = (h ^ (unsigned int)s[i].symbvalue()) * 16777619u;
+  return (h ^ len) * 16777619u;
+}
+
+//////////////////////////////////////////////////////////////////////
+// class tracebuffer
+
+tracebuffer::tracebuffer(tracer &owner, unsigned int id)
+  : t(owner), thread(id), head(0), used(0), tail(0) {
+  for (int i = 0; i < TRACE_RINGSIZE; i++) {
+    chunks[i] = new traceevent[TRACE_CHUNKEVENTS];
+    nfull[i] = 0;
+  }
+}
+
+tracebuffer::~tracebuffer() {
+  for (int i = 0; i < TRACE_RINGSIZE; i++)
+    delete[] chunks[i];
+}
+
+/**
+ * passes the current chunk to the writer and waits for the next one
+ * in the ring to be free. Called with the tracer lock held.
+ */
+
+void tracebuffer::flush() {
+  nfull[head] = used;
+  head = (head + 1) % TRACE_RINGSIZE;
+  used = 0;
+  pthread_cond_broadcast(&t.cond);
+  while (nfull[head] != 0) {
+    t.stalls++;
+    pthread_cond_wait(&t.cond, &t.lock);
+  }
+}
+
+void tracebuffer::handover() {
+  pthread_mutex_lock(&t.lock);
+  flush();
+  pthread_mutex_unlock(&t.lock);
+}
+
+//////////////////////////////////////////////////////////////////////
+// class tracer
+
+tracer::tracer(const string &fn) : closing(false), stalls(0) {
+  f = fopen(fn.c_str(), "wb");
+  if (f == 0) throw error("Failed to open trace file");
+  fwrite(TRACE_MAGIC, 1, 8, f);
+  pthread_mutex_init(&lock, 0);
+  pthread_cond_init(&cond, 0);
+  if (pthread_create(&writer, 0, writerloop, this) != 0) {
+    fclose(f);
+    pthread_mutex_destroy(&lock);
+    pthread_cond_destroy(&cond);
+    throw error("Failed to start trace writer thread");
+  }
+}
+
+tracer::~tracer() {
+  close();
+  for (unsigned i = 0; i < buffers.size(); i++)
+    delete buffers[i];
+  pthread_mutex_destroy(&lock);
+  pthread_cond_destroy(&cond);
+}
+
+tracebuffer *tracer::buffer() {
+  pthread_mutex_lock(&lock);
+  tracebuffer *b = new tracebuffer(*this, buffers.size());
+  buffers.push_back(b);
+  pthread_mutex_unlock(&lock);
+  return b;
+}
+
+/**
+ * writes one pending chunk, if any. Called with the lock held; the
+ * lock is released during the write since the producer does not touch
+ * a chunk until it is marked free.
+ */
+
+bool tracer::writepending() {
+  for (unsigned i = 0; i < buffers.size(); i++) {
+    tracebuffer *b = buffers[i];
+    int n = b->nfull[b->tail];
+    if (n == 0)
+      continue;
+    tracechunk hdr = { b->thread, (unsigned int)n };
+    traceevent *ev = b->chunks[b->tail];
+    pthread_mutex_unlock(&lock);
+    fwrite(&hdr, sizeof(hdr), 1, f);
+    fwrite(ev, sizeof(traceevent), n, f);
+    pthread_mutex_lock(&lock);
+    b->nfull[b->tail] = 0;
+    b->tail = (b->tail + 1) % TRACE_RINGSIZE;
+    pthread_cond_broadcast(&cond);
+    return true;
+  }
+  return false;
+}
+
+void *tracer::writerloop(void *arg) {
+  tracer *t = (tracer*)arg;
+  pthread_mutex_lock(&t->lock);
+  while (1) {
+    if (t->writepending())
+      continue;
+    if (t->closing)
+      break;
+    pthread_cond_wait(&t->cond, &t->lock);
+  }
+  pthread_mutex_unlock(&t->lock);
+  return 0;
+}
+
+/**
+ * hands over all partially filled chunks and waits for the writer to
+ * drain them. The traced threads must have stopped.
+ */
+
+void tracer::close() {
+  if (f == 0)
+    return;
+  pthread_mutex_lock(&lock);
+  for (unsigned i = 0; i < buffers.size(); i++) {
+    tracebuffer *b = buffers[i];
+    if (b->used) {
+      b->nfull[b->head] = b->used;
+      b->head = (b->head + 1) % TRACE_RINGSIZE;
+      b->used = 0;
+    }
+  }
+  closing = true;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&lock);
+  pthread_join(writer, 0);
+  fclose(f);
+  f = 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// class tracedict
+
+symbolset tracedict::findpossible(symbol *s, int len, int pos) {
+  symbolset ss = d.findpossible(s, len, pos);
+  tracebuffer *tb = tracebuf();
+  if (tb)
+    tb->add(TRACE_QUERY, -1, numones(ss), 0, len, pos, patternsignature(s, len));
+  return ss;
+}
@@ -0,0 +1,140 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef TRACE_HH
+#define TRACE_HH
+
+#include <stdio.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include "symbol.hh"
+#include "dict.hh"
+
+/**
+ * Binary search traces. Events have a fixed size of 16 bytes and are
+ * appended to a per-thread ring of chunks. Full chunks are written to
+ * the trace file by a writer thread, so the search only pays for a
+ * store and an occasional hand-over. cwctrace analyzes the file.
+ *
+ * File layout: the magic "CWCTRACE", then chunks, each a tracechunk
+ * header followed by its events.
+ */
+
+enum {
+  TRACE_DESCEND = 1,  // cell, arg = depth
+  TRACE_ASSIGN,       // cell, sym, arg = depth
+  TRACE_DEADEND,      // cell, arg = depth
+  TRACE_BACKJUMP,     // cell = from, arg = to, extra = distance
+  TRACE_QUERY         // len, pos, arg = letters found, extra = pattern signature
+};
+
+struct traceevent {
+  unsigned char type, sym, len, pos;
+  int cell;
+  int arg;
+  unsigned int extra;
+};
+
+struct tracechunk {
+  unsigned int thread, nevents;
+};
+
+#define TRACE_MAGIC "CWCTRACE"
+#define TRACE_CHUNKEVENTS 4096
+#define TRACE_RINGSIZE 8
+
+class tracer;
+
+class tracebuffer {
+  friend class tracer;
+  tracer &t;
+  unsigned int thread;
+  traceevent *chunks[TRACE_RINGSIZE];
+  int nfull[TRACE_RINGSIZE];     // events in a chunk, 0 = free
+  int head, used;                // chunk being filled
+  int tail;                      // next chunk to write
+  void flush();
+  void handover();
+public:
+  tracebuffer(tracer &owner, unsigned int id);
+  ~tracebuffer();
+  inline void add(int type, int cell, int arg, int sym = 0, int len = 0,
+		  int pos = 0, unsigned int extra = 0);
+};
+
+class tracer {
+  friend class tracebuffer;
+  FILE *f;
+  pthread_t writer;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  bool closing;
+  vector<tracebuffer*> buffers;
+  static void *writerloop(void *);
+  bool writepending();
+public:
+  long stalls;
+  tracer(const string &fn);
+  ~tracer();
+  tracebuffer *buffer();  // the calling thread's buffer
+  void close();
+};
+
+/**
+ * the active tracer, 0 when tracing is off.
+ */
+
+extern tracer *activetracer;
+
+/**
+ * returns the calling thread's buffer of the active tracer, or 0 if
+ * tracing is off.
+ */
+
+tracebuffer *tracebuf();
+
+unsigned int patternsignature(symbol *s, int len);
+
+/**
+ * tracedict forwards to another dictionary and records every query.
+ * The inner dictionary is owned by the tracedict.
+ */
+
+class tracedict : public dict {
+  dict &d;
+public:
+  tracedict(dict *inner) : d(*inner) {}
+  ~tracedict() { delete &d; }
+  void load(const string &fn) { d.load(fn); }
+  symbolset findpossible(symbol *s, int len, int pos);
+  long memusage() { return d.memusage(); }
+  void profilemem() { d.profilemem(); }
+};
+
+void tracebuffer::add(int type, int cell, int arg, int sym, int len, int pos,
+		      unsigned int extra) {
+  traceevent &e = chunks[head][used++];
+  e.type = type; e.sym = sym; e.len = len; e.pos = pos;
+  e.cell = cell; e.arg = arg; e.extra = extra;
+  if (used == TRACE_CHUNKEVENTS)
+    handover();
+}
+
+#endif
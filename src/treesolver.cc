@@ -0,0 +1,323 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#include <iostream.h>
+#include <algo.h>
+#include <set>
+
+#include "symbol.hh"
+#include "timer.hh"
+#include "progress.hh"
+#include "treesolver.hh"
+
+//////////////////////////////////////////////////////////////////////
+// class treesolver
+
+treesolver::treesolver(grid &thegrid, dict &thedict)
+  : g(thegrid), d(thedict), width_(0), cachedsymbols(0), aborted(false),
+    tb(0), lastreport(0), lastreportnodes(0), nodelimit(0),
+    showsteps(false), progressinterval(500), cachehits(0), contexts(0) {
+}
+
+// fill-in edges the elimination of v would add
+static long fillin(vector<set<int> > &nb, int v) {
+  long fill = 0;
+  for (set<int>::iterator a = nb[v].begin(); a != nb[v].end(); a++) {
+    set<int>::iterator b = a;
+    for (b++; b != nb[v].end(); b++)
+      if (nb[*a].find(*b) == nb[*a].end())
+	fill++;
+  }
+  return fill;
+}
+
+/**
+ * builds the elimination tree. Stops as soon as a context grows
+ * beyond maxwidth. The cells wait in a queue ordered by fill-in, then
+ * degree, then number; eliminating a cell only changes the fill-in of
+ * cells within two steps of it, and only those are requeued, so a
+ * chain is decomposed in linear time.
+ */
+
+bool treesolver::decompose(int maxwidth) {
+  int ncells = g.numcells();
+  vector<int> var(ncells, -1);
+  cells.clear();
+  for (int c = 0; c < ncells; c++)
+    if (g.cellno(c).isempty()) {
+      var[c] = cells.size();
+      cells.push_back(c);
+    }
+  int n = cells.size();
+
+  // the cell graph as adjacency sets, changed while eliminating
+  vector<set<int> > nb(n);
+  for (int v = 0; v < n; v++) {
+    cell &c = g.cellno(cells[v]);
+    for (int w = 0; w < c.numwords(); w++) {
+      wordblock &wb = c.getwordblock(w);
+      for (int i = 0; i < wb.length(); i++) {
+	int u = var[wb.getcellno(i)];
+	if (u >= 0 && u != v)
+	  nb[v].insert(u);
+      }
+    }
+  }
+  linked.assign(n, vector<int>());
+  for (int v = 0; v < n; v++)
+    linked[v].assign(nb[v].begin(), nb[v].end());
+
+  typedef pair<pair<long, int>, int> rank_t;   // ((fill, degree), cell)
+  set<rank_t> byfill;
+  vector<rank_t> key(n);
+  for (int v = 0; v < n; v++) {
+    key[v] = rank_t(pair<long, int>(fillin(nb, v), nb[v].size()), v);
+    byfill.insert(key[v]);
+  }
+
+  vector<int> order;
+  context.assign(n, vector<int>());
+  width_ = 0;
+  while (!byfill.empty()) {
+    int best = byfill.begin()->second;
+    byfill.erase(byfill.begin());
+    set<int> &ns = nb[best];
+    context[best].assign(ns.begin(), ns.end());
+    if (int(ns.size()) > width_)
+      width_ = ns.size();
+    if (width_ > maxwidth)
+      return false;
+
+    // connect the neighbours and take the cell out
+    vector<int> &ctx = context[best];
+    for (unsigned a = 0; a < ctx.size(); a++) {
+      nb[ctx[a]].erase(best);
+      for (unsigned b = a+1; b < ctx.size(); b++) {
+	nb[ctx[a]].insert(ctx[b]);
+	nb[ctx[b]].insert(ctx[a]);
+      }
+    }
+    ns.clear();
+    order.push_back(best);
+
+    // requeue the cells whose fill-in may have changed
+    set<int> touched;
+    for (unsigned a = 0; a < ctx.size(); a++) {
+      touched.insert(ctx[a]);
+      touched.insert(nb[ctx[a]].begin(), nb[ctx[a]].end());
+    }
+    for (set<int>::iterator t = touched.begin(); t != touched.end(); t++) {
+      byfill.erase(key[*t]);
+      key[*t] = rank_t(pair<long, int>(fillin(nb, *t), nb[*t].size()), *t);
+      byfill.insert(key[*t]);
+    }
+  }
+
+  // the parent is the context cell eliminated first
+  vector<int> rank(n);
+  for (int i = 0; i < n; i++) rank[order[i]] = i;
+  for (int v = 0; v < n; v++) {
+    vector<int> up;
+    for (unsigned k = 0; k < linked[v].size(); k++)
+      if (rank[linked[v][k]] > rank[v])
+	up.push_back(linked[v][k]);
+    linked[v].swap(up);
+  }
+  parent.assign(n, -1);
+  children.assign(n, vector<int>());
+  roots.clear();
+  for (int i = n-1; i >= 0; i--) {
+    int v = order[i];
+    for (unsigned k = 0; k < context[v].size(); k++) {
+      int u = context[v][k];
+      if (parent[v] < 0 || rank[u] < rank[parent[v]])
+	parent[v] = u;
+    }
+    if (parent[v] < 0)
+      roots.push_back(v);
+    else
+      children[parent[v]].push_back(v);
+  }
+
+  // subtrees as ranges of one preorder array; children come before
+  // their parents in the elimination order
+  subsize.assign(n, 1);
+  for (int i = 0; i < n; i++)
+    if (parent[order[i]] >= 0)
+      subsize[parent[order[i]]] += subsize[order[i]];
+  substart.assign(n, 0);
+  int next = 0;
+  for (unsigned r = 0; r < roots.size(); r++) {
+    substart[roots[r]] = next;
+    next += subsize[roots[r]];
+  }
+  for (int i = n-1; i >= 0; i--) {
+    int v = order[i], at = substart[v] + 1;
+    for (unsigned k = 0; k < children[v].size(); k++) {
+      substart[children[v][k]] = at;
+      at += subsize[children[v][k]];
+    }
+  }
+  preorder.assign(n, 0);
+  for (int v = 0; v < n; v++)
+    preorder[substart[v]] = v;
+  cache.assign(n, map<string, int>());
+  fillings.clear();
+  nogoods.clear();
+  cachedsymbols = 0;
+  return true;
+}
+
+string treesolver::contextkey(int v) {
+  string key;
+  for (unsigned i = 0; i < context[v].size(); i++)
+    key += char(g.cellno(cells[context[v][i]]).getsymbol().symbvalue());
+  return key;
+}
+
+void treesolver::clearsubtree(int v) {
+  for (int i = 1; i < subsize[v]; i++)
+    g.cellno(cells[preorder[substart[v] + i]]).setsymbol(symbol::empty);
+}
+
+/**
+ * fills the subtree of v, the ancestors being filled. The children
+ * of v are independent given v and its context, so all must succeed
+ * for one letter of v. On failure conflict holds the ancestors the
+ * failure depends on.
+ */
+
+bool treesolver::solvevar(int v, int depth, vector<int> &conflict) {
+  stats.nodes++;
+  if (nodelimit && stats.nodes > nodelimit) {
+    aborted = true;
+    return false;
+  }
+  if (searchevents)
+    handleevents(depth);
+  if (depth > stats.maxdepth)
+    stats.maxdepth = depth;
+  int cno = cells[v];
+  if (tb)
+    tb->add(TRACE_DESCEND, cno, depth);
+
+  string key = contextkey(v);
+  map<string, int>::iterator hit = cache[v].find(key);
+  if (hit != cache[v].end()) {
+    cachehits++;
+    if (hit->second < 0) {
+      conflict = nogoods[-1 - hit->second];
+      return false;
+    }
+    vector<symbol> &f = fillings[hit->second];
+    for (unsigned i = 0; i < f.size(); i++)
+      g.cellno(cells[preorder[substart[v] + i]]).setsymbol(f[i]);
+    return true;
+  }
+
+  cell &c = g.cellno(cno);
+  symbolset ss = c.findpossible(d);
+  // the letters left depend on the slots' filled cells
+  conflict = linked[v];
+  vector<int> below, merged;
+  bool ok = false;
+  for (symbolset bit = pickbit(ss); bit && !ok; bit = pickbit(ss)) {
+    symbol s = symbol::symbolbit(bit);
+    c.setsymbol(s);
+    if (tb)
+      tb->add(TRACE_ASSIGN, cno, depth, s.symbvalue());
+    ok = true;
+    for (unsigned k = 0; k < children[v].size() && ok; k++)
+      ok = solvevar(children[v][k], depth + 1, below);
+    if (aborted)
+      return false;
+    if (ok)
+      break;
+    stats.backtracks++;
+    clearsubtree(v);
+    if (!binary_search(below.begin(), below.end(), v)) {
+      // no letter of v can help; the ancestors named have to change
+      conflict.swap(below);
+      break;
+    }
+    merged.clear();
+    set_union(conflict.begin(), conflict.end(), below.begin(), below.end(),
+	      back_inserter(merged));
+    merged.erase(lower_bound(merged.begin(), merged.end(), v));
+    conflict.swap(merged);
+  }
+
+  contexts++;
+  if (!ok) {
+    STAT(stats.deadends[cno]++);
+    if (tb)
+      tb->add(TRACE_DEADEND, cno, depth);
+    c.setsymbol(symbol::empty);
+    cache[v][key] = -1 - int(nogoods.size());
+    nogoods.push_back(conflict);
+    return false;
+  }
+  if (cachedsymbols + subsize[v] <= TREECACHESYMBOLS) {
+    vector<symbol> f(subsize[v]);
+    for (unsigned i = 0; i < f.size(); i++)
+      f[i] = g.cellno(cells[preorder[substart[v] + i]]).getsymbol();
+    cache[v][key] = fillings.size();
+    fillings.push_back(f);
+    cachedsymbols += f.size();
+  }
+  return true;
+}
+
+/**
+ * as compiler::handleevents, with the depth in the tree.
+ */
+
+void treesolver::handleevents(int depth) {
+  int ev = __sync_lock_test_and_set(&searchevents, 0);
+  if (ev & STATS_EVENT)
+    stats.dump(cerr, false);
+  if ((ev & PROGRESS_EVENT) && showsteps) {
+    long long now = hrtime();
+    double secs = (now - lastreport) / 1e9;
+    cout << "depth " << depth << " (best " << stats.maxdepth << "), "
+	 << stats.nodes << " nodes, "
+	 << long((stats.nodes - lastreportnodes) / secs) << " nodes/s" << endl;
+    g.dump_simple(cout);
+    lastreport = now;
+    lastreportnodes = stats.nodes;
+  }
+}
+
+bool treesolver::solve() {
+  stats.reset();
+  installstatshandler();
+  lastreport = hrtime();
+  lastreportnodes = 0;
+  tb = tracebuf();
+  aborted = false;
+  if (showsteps)
+    startprogresstimer(progressinterval);
+  bool ok = true;
+  vector<int> conflict;
+  for (unsigned r = 0; r < roots.size() && ok; r++)
+    ok = solvevar(roots[r], 1, conflict);
+  if (showsteps)
+    stopprogresstimer();
+  return ok;
+}
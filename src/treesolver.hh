@@ -0,0 +1,102 @@
+/**
+ * cwc - a crossword compiler. Copyright 1999 Lars Christensen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA. 
+ **/
+
+#ifndef TREESOLVER_HH
+#define TREESOLVER_HH
+
+#include <vector>
+#include <map>
+#include <string>
+#include "main.hh"
+#include "grid.hh"
+#include "dict.hh"
+#include "stats.hh"
+#include "trace.hh"
+
+/**
+ * The tree solver handles sparsely interlocked grids. The empty cells
+ * are eliminated one by one, fewest fill-in edges first, which gives
+ * a tree decomposition of the cell graph (cells are linked when they
+ * share a slot). Every cell gets a parent, the next eliminated of its
+ * neighbours, and a context: its neighbours at elimination time. They
+ * are exactly the ancestors that slots from its subtree reach. The
+ * width is the largest context.
+ *
+ * The search walks the tree from the roots. Sibling subtrees are
+ * independent and are solved one after the other without ever
+ * backtracking into each other. Whether a subtree can be filled
+ * depends only on the letters of its context, so the outcome is
+ * cached under them. A failure is a nogood, and a success keeps the
+ * subtree's letters to be restored. With width w a subtree is solved
+ * at most 26^w times, which makes chains linear.
+ *
+ * A failure also names the ancestors it depends on: those in the
+ * cell's slots, and those the failures below depended on. When a
+ * child fails whatever letter its parent has, the parent gives up at
+ * once and the search jumps back to the nearest ancestor named, as
+ * the backtracking search does. The node limit, progress reports and
+ * the search trace work as in the compiler.
+ */
+
+#define TREECACHESYMBOLS (8L << 20)  // budget for cached fillings
+
+class treesolver {
+  grid &g;
+  dict &d;
+  vector<int> cells;             // the empty cells, by variable
+  vector<int> parent;            // -1 for roots
+  vector<vector<int> > children, context;
+  vector<int> preorder;          // all subtrees, each a range of it
+  vector<int> substart, subsize; // the range of each cell's subtree
+  vector<int> roots;
+  vector<vector<int> > linked;   // ancestors sharing a slot, sorted
+  int width_;
+  // context letters -> filling, or -1-n for the failure of nogoods[n]
+  vector<map<string, int> > cache;
+  vector<vector<symbol> > fillings;
+  vector<vector<int> > nogoods;  // the ancestors each failure depends on
+  long cachedsymbols;
+  bool aborted;
+  tracebuffer *tb;
+  long long lastreport;
+  long lastreportnodes;
+
+  string contextkey(int v);
+  bool solvevar(int v, int depth, vector<int> &conflict);
+  void clearsubtree(int v);
+  void handleevents(int depth);
+public:
+  treesolver(grid &thegrid, dict &thedict);
+  // false if the width exceeds maxwidth
+  bool decompose(int maxwidth);
+  int width() { return width_; }
+  int numtrees() { return roots.size(); }
+  bool solve();
+  bool wasaborted() { return aborted; }
+
+  // as for the compiler
+  long nodelimit;
+  bool showsteps;
+  int progressinterval;
+
+  searchstats stats;
+  long cachehits, contexts;
+};
+
+#endif
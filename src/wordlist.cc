@@ -19,17 +19,28 @@
 
 #include <fstream>
 #include "wordlist.hh"
+#include "gridscope.hh"
 
-wordlist::wordlist() {
+#define chunksize 8192
+
+wordlist::wordlist() : chunkused(chunksize) {
   allalpha = 0;
 }
 
-#define chunksize 8192
+wordlist::~wordlist() {
+  for (unsigned i = 0; i < chunks.size(); i++)
+    delete[] chunks[i];
+}
+
+long wordlist::memusage() {
+  return chunks.size() * chunksize * sizeof(symbol)
+    + widx.capacity() * sizeof(symbol*);
+}
 
 bool wordlist::wordok(const string &fn) {
   int n = fn.length();
   for (int i=0;i<n;i++)
-    if (!isalpha(fn[i]))
+    if (!wordchar(fn[i]))
       return false;
   return true;
 }
@@ -40,32 +51,41 @@ void wordlist::load(const string &fn) {
 
   widx.clear();
 
-  symbol *chunk = new symbol[chunksize];
-  int chunkused = 0;
-
   string ln;
   while (!f.eof()) {
     getline(f, ln);
-    int wlen = ln.length();
-    if (wlen == 0)
-      continue;
-    if (!wordok(ln))
+    if (activescope && !activescope->allows(ln))
       continue;
-    
-    if (chunksize - chunkused < wlen+1) {
-      chunk = new symbol[chunksize];
-      chunkused = 0;
-    }
+    addword(ln);
+  }
+}
+
+/**
+ * appends a word, lowercased; returns false if it is empty or has
+ * characters other than letters.
+ */
 
-    symbol *addr = chunk + chunkused;
-    for (int i=0; i<wlen; i++) {
-      symbol s = symbol(tolower(ln[i]));
-      chunk[chunkused++] = s;
-      allalpha |= s.getsymbolset();
-    }
-    chunk[chunkused++] = symbol::outside;
+bool wordlist::addword(const string &ln) {
+  int wlen = ln.length();
+  if (wlen == 0)
+    return false;
+  if (!wordok(ln))
+    return false;
 
-    widx.push_back(addr);
+  if (chunksize - chunkused < wlen+1) {
+    chunks.push_back(new symbol[chunksize]);
+    chunkused = 0;
   }
+
+  symbol *chunk = chunks.back();
+  symbol *addr = chunk + chunkused;
+  for (int i=0; i<wlen; i++) {
+    symbol s = symbol(tolower(ln[i]));
+    chunk[chunkused++] = s;
+    allalpha |= s.getsymbolset();
+  }
+  chunk[chunkused++] = symbol::outside;
+
+  widx.push_back(addr);
+  return true;
 }
-  
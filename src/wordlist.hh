@@ -32,12 +32,17 @@
 class wordlist {
 protected:
   vector<symbol*> widx;
+  vector<symbol*> chunks;
+  int chunkused;
   bool wordok(const string &st);
   int nwords;
 public:
   symbolset allalpha;
   wordlist();
+  ~wordlist();
   void load(const string &fn);
+  bool addword(const string &w);
+  long memusage();
   int numwords() {
     return widx.size();
   }